@@ -7,7 +7,7 @@ void AIChoiceSystem::react_to_event(AwaitingActionSignal& signal)
 	{
 		IssueCommandSignal issue;
 
-		TCODRandom* rng = TCODRandom::getInstance();
+		TCODRandom* rng = get_random().substream(RandomStream::AI, entt::to_integral(candidate));
 
 		if (rng->getInt(0, 100) > 30)
 		{
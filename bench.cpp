@@ -0,0 +1,192 @@
+// level generation benchmark. this is its own executable (bench_levels.vcxproj), so the
+// allocation-counting operator new below never ends up in the game.
+
+#include "config.h"
+#include "level.h"
+#include "profiler.h"
+#include "random.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <vector>
+
+// every operator new in the process (not malloc or calloc); the benchmark reads the difference around each stage
+static std::atomic<long long> allocations{ 0 };
+
+void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (void* memory = std::malloc(size > 0 ? size : 1))
+        return memory;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+struct StageSampler : public LevelStageObserver
+{
+    double ms[(int)LevelStage::COUNT];
+    long long allocated[(int)LevelStage::COUNT];
+
+    void reset()
+    {
+        std::fill(std::begin(ms), std::end(ms), 0.0);
+        std::fill(std::begin(allocated), std::end(allocated), 0ll);
+    }
+
+    void begin_stage(LevelStage) override
+    {
+        started = ProfileClock::now();
+        allocations_at_start = allocations.load(std::memory_order_relaxed);
+    }
+
+    void end_stage(LevelStage stage) override
+    {
+        ms[(int)stage] += std::chrono::duration<double, std::milli>(ProfileClock::now() - started).count();
+        allocated[(int)stage] += allocations.load(std::memory_order_relaxed) - allocations_at_start;
+    }
+
+private:
+    ProfileClock::time_point started;
+    long long allocations_at_start = 0;
+};
+
+struct StageSummary
+{
+    std::vector<double> ms;
+    long long allocated = 0;
+
+    void print(const char* name, int runs)
+    {
+        std::sort(ms.begin(), ms.end());
+
+        double total = 0.0;
+        for (auto sample : ms) total += sample;
+
+        const auto percentile = [&](int p) { return ms[(ms.size() - 1) * p / 100]; };
+
+        printf("  %-24s %10.3f %10.3f %10.3f %12.1f\n", name, total / ms.size(), percentile(50), percentile(99), (double)allocated / runs);
+    }
+};
+
+struct BenchSize
+{
+    int width;
+    int height;
+};
+
+// generates `warmup` untimed levels and then `runs` timed ones at each size, seeds stepping on
+// from `seed`, and prints every stage's mean, p50 and p99 time plus its operator new calls per run
+static int run_level_benchmark(int runs, int warmup, uint64_t seed, const std::vector<BenchSize>& sizes)
+{
+    printf("level generation: %d runs per size after %d warm-up, seeds from %llu\n", runs, warmup, (unsigned long long)seed);
+    printf("new/run counts operator new only; malloc/calloc (libtcod's included) are not seen\n");
+
+    StageSampler sampler;
+
+    // one level and arena for every run, like restarts in game
+    std::unique_ptr<Level> level{ new Level };
+    LevelArena arena;
+
+    for (const auto& size : sizes)
+    {
+        // the first levels at a size grow the arena and the level's grids; they are left out of the figures
+        for (int run = 0; run < warmup; run++)
+        {
+            level->generate(split_seed(seed, runs + run), size.width, size.height, &arena);
+        }
+
+        StageSummary stages[(int)LevelStage::COUNT];
+        StageSummary whole;
+
+        for (int run = 0; run < runs; run++)
+        {
+            sampler.reset();
+
+            const auto started = ProfileClock::now();
+            const auto allocations_at_start = allocations.load(std::memory_order_relaxed);
+
+            level->generate(split_seed(seed, run), size.width, size.height, &arena, &sampler);
+
+            whole.ms.push_back(std::chrono::duration<double, std::milli>(ProfileClock::now() - started).count());
+            whole.allocated += allocations.load(std::memory_order_relaxed) - allocations_at_start;
+
+            for (int i = 0; i < (int)LevelStage::COUNT; i++)
+            {
+                stages[i].ms.push_back(sampler.ms[i]);
+                stages[i].allocated += sampler.allocated[i];
+            }
+        }
+
+        printf("\n%dx%d\n", size.width, size.height);
+        printf("  %-24s %10s %10s %10s %12s\n", "stage", "mean ms", "p50 ms", "p99 ms", "new/run");
+
+        for (int i = 0; i < (int)LevelStage::COUNT; i++)
+        {
+            stages[i].print(get_level_stage_name((LevelStage)i), runs);
+        }
+
+        whole.print("generate", runs);
+    }
+
+    return 0;
+}
+
+#undef main
+
+int main(int argc, char* argv[])
+{
+    int runs = 100;
+    int warmup = 2;
+    std::vector<BenchSize> sizes{ { MAP_WIDTH, MAP_HEIGHT }, { MAP_WIDTH * 2, MAP_HEIGHT * 2 }, { MAP_WIDTH * 4, MAP_HEIGHT * 4 } };
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc)
+        {
+            runs = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+        {
+            warmup = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            get_random().set_seed(strtoull(argv[++i], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--map-size") == 0 && i + 1 < argc)
+        {
+            // one size instead of the default three
+            BenchSize size;
+            if (sscanf(argv[++i], "%dx%d", &size.width, &size.height) != 2 || size.width <= 0 || size.height <= 0)
+            {
+                printf("--map-size expects WxH\n");
+                return 1;
+            }
+            sizes = { size };
+        }
+    }
+
+    if (runs <= 0 || warmup < 0)
+    {
+        printf("--runs must be positive and --warmup not negative\n");
+        return 1;
+    }
+
+    return run_level_benchmark(runs, warmup, get_random().get_seed(), sizes);
+}
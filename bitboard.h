@@ -0,0 +1,200 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// life-like rule: bit n of birth/survive is set when a cell with n live neighbours is born/survives
+struct CellularRule
+{
+    uint16_t birth;
+    uint16_t survive;
+
+    static constexpr uint16_t counts(int from, int to)
+    {
+        uint16_t mask = 0;
+        for (int n = from; n <= to; n++) mask |= (uint16_t)(1 << n);
+        return mask;
+    }
+};
+
+// drops open cells with no open neighbours, nothing is born (the original dig cleanup)
+constexpr CellularRule CA_PRUNE_ISOLATED{ 0, CellularRule::counts(1, 8) };
+// B5678/S45678: fills pockets and rounds off caves
+constexpr CellularRule CA_CAVE_SMOOTHING{ CellularRule::counts(5, 8), CellularRule::counts(4, 8) };
+// B678/S345678: closes single-tile gaps while keeping thin corridors
+constexpr CellularRule CA_CLOSE_GAPS{ CellularRule::counts(6, 8), CellularRule::counts(3, 8) };
+
+namespace bitboard
+{
+    inline uint64_t valid(int width, int w)
+    {
+        const int bits = width - w * 64;
+        return bits >= 64 ? ~0ull : (1ull << bits) - 1;
+    }
+
+    // each bit gets the cell to its left (x - 1) or right (x + 1), carried across word edges
+    inline uint64_t west(const uint64_t* row, int w)
+    {
+        return (row[w] << 1) | (w > 0 ? row[w - 1] >> 63 : 0);
+    }
+
+    inline uint64_t east(const uint64_t* row, int w, int words)
+    {
+        return (row[w] >> 1) | (w + 1 < words ? row[w + 1] << 63 : 0);
+    }
+
+    // bit-sliced counter: count[k] holds bit k of every cell's neighbour count
+    inline void add(uint64_t count[4], uint64_t in)
+    {
+        const auto carry0 = count[0] & in;
+        count[0] ^= in;
+        const auto carry1 = count[1] & carry0;
+        count[1] ^= carry0;
+        const auto carry2 = count[2] & carry1;
+        count[2] ^= carry1;
+        count[3] |= carry2;
+    }
+
+    inline uint64_t equals(const uint64_t count[4], int n)
+    {
+        uint64_t result = ~0ull;
+        for (int k = 0; k < 4; k++)
+        {
+            result &= ((n >> k) & 1) ? count[k] : ~count[k];
+        }
+        return result;
+    }
+
+    // one synchronous generation from `rows` into `next`; everything outside the board counts as dead.
+    // a non-zero FixedWidth/FixedHeight bakes the size in, so the common map size gets constant loop bounds.
+    template<int FixedWidth = 0, int FixedHeight = 0>
+    void step(const uint64_t* rows, uint64_t* next, int width, int height, const CellularRule& rule)
+    {
+        if (FixedWidth != 0) width = FixedWidth;
+        if (FixedHeight != 0) height = FixedHeight;
+        const int words = (width + 63) / 64;
+
+        for (int y = 0; y < height; y++)
+        {
+            for (int w = 0; w < words; w++)
+            {
+                uint64_t count[4]{ 0, 0, 0, 0 };
+
+                for (int dy = -1; dy <= 1; dy++)
+                {
+                    if (y + dy < 0 || y + dy >= height) continue;
+
+                    const auto* row = rows + (y + dy) * words;
+                    add(count, west(row, w));
+                    add(count, east(row, w, words));
+                    if (dy != 0) add(count, row[w]);
+                }
+
+                const auto alive = rows[y * words + w];
+                uint64_t result = 0;
+                for (int n = 0; n <= 8; n++)
+                {
+                    const bool born = (rule.birth >> n) & 1;
+                    const bool stays = (rule.survive >> n) & 1;
+                    if (!born && !stays) continue;
+
+                    const auto with_n = equals(count, n);
+                    if (born) result |= with_n & ~alive;
+                    if (stays) result |= with_n & alive;
+                }
+
+                next[y * words + w] = result & valid(width, w);
+            }
+        }
+    }
+}
+
+// W x H cells packed 64 to a word, one row after another. cells past the width stay zero,
+// so whole-word operations never leak across the right edge.
+template<int W, int H>
+struct Bitboard
+{
+    static constexpr int WORDS = (W + 63) / 64;
+
+    uint64_t rows[H][WORDS];
+
+    Bitboard()
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        memset(rows, 0, sizeof(rows));
+    }
+
+    bool get(int x, int y) const
+    {
+        return (rows[y][x >> 6] >> (x & 63)) & 1;
+    }
+
+    void set(int x, int y, bool on = true)
+    {
+        const auto bit = 1ull << (x & 63);
+        if (on)
+            rows[y][x >> 6] |= bit;
+        else
+            rows[y][x >> 6] &= ~bit;
+    }
+
+    void step(const CellularRule& rule)
+    {
+        uint64_t next[H][WORDS];
+        bitboard::step<W, H>(&rows[0][0], &next[0][0], W, H, rule);
+        memcpy(rows, next, sizeof(rows));
+    }
+};
+
+// the same board with its size picked at runtime, for maps other than the default
+struct DynamicBitboard
+{
+    DynamicBitboard() {}
+
+    DynamicBitboard(int width, int height)
+    {
+        resize(width, height);
+    }
+
+    // clears every cell; the storage is kept when the new size fits in it
+    void resize(int width, int height)
+    {
+        this->width = width;
+        this->height = height;
+        words = (width + 63) / 64;
+        rows.assign((size_t)words * height, 0);
+        next.assign((size_t)words * height, 0);
+    }
+
+    bool get(int x, int y) const
+    {
+        return (rows[y * words + (x >> 6)] >> (x & 63)) & 1;
+    }
+
+    void set(int x, int y, bool on = true)
+    {
+        const auto bit = 1ull << (x & 63);
+        if (on)
+            rows[y * words + (x >> 6)] |= bit;
+        else
+            rows[y * words + (x >> 6)] &= ~bit;
+    }
+
+    void step(const CellularRule& rule)
+    {
+        bitboard::step(rows.data(), next.data(), width, height, rule);
+        rows.swap(next);
+    }
+
+private:
+    int width = 0;
+    int height = 0;
+    int words = 0;
+    std::vector<uint64_t> rows;
+    std::vector<uint64_t> next;
+};
@@ -0,0 +1,296 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "config.h"
+
+// fnv-1a over a cell's fields, for cell types whose bytes aren't their value (padding, floats)
+struct CellHash
+{
+    uint64_t h = 14695981039346656037ull;
+
+    CellHash& add(const void* data, size_t size)
+    {
+        const auto* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; i++) h = (h ^ bytes[i]) * 1099511628211ull;
+        return *this;
+    }
+
+    CellHash& add(char value) { return add(&value, 1); }
+
+    // -0 and 0 compare equal, so they hash alike
+    CellHash& add(float value)
+    {
+        if (value == 0.0f) value = 0.0f;
+        return add(&value, sizeof(value));
+    }
+
+    size_t done() const { return (size_t)(h ^ (h >> 32)); }
+};
+
+template<typename T, typename = void>
+struct has_cell_hash : std::false_type {};
+
+template<typename T>
+struct has_cell_hash<T, std::void_t<decltype(std::declval<const T&>().hash())>> : std::true_type {};
+
+// a width x height grid cut into square chunks, row-major both across and within chunks. a chunk only gets cells the first time it is
+// written; until then it reads as the fill value. compress() packs a chunk into a palette of its
+// distinct values plus one small index per cell, and frees its cells; reads stay a lookup, and the
+// next write unpacks it. grid[x][y] reads and writes a cell as with Grid.
+template<typename T>
+struct ChunkedGrid
+{
+    static constexpr int SHIFT = CHUNK_SHIFT;
+    static constexpr int SIZE = 1 << SHIFT;
+    static constexpr int MASK = SIZE - 1;
+    static constexpr int CELLS = SIZE * SIZE;
+
+    static_assert(CELLS <= 65536, "packed cells index the palette in 16 bits");
+    static_assert(std::is_trivially_copyable_v<T>, "packing copies cells byte by byte");
+    static_assert(has_cell_hash<T>::value || std::has_unique_object_representations_v<T>,
+        "a cell with padding or floats needs a hash() over its fields");
+
+    struct Column
+    {
+        ChunkedGrid* grid;
+        int x;
+
+        T& operator[](int y) { return grid->at(x, y); }
+    };
+
+    struct ConstColumn
+    {
+        const ChunkedGrid* grid;
+        int x;
+
+        T operator[](int y) const { return grid->get(x, y); }
+    };
+
+    void resize(int width, int height, const T& value = T{})
+    {
+        if (width == this->width && height == this->height)
+        {
+            fill(value);
+            return;
+        }
+
+        this->width = width;
+        this->height = height;
+        chunks_x = (width + MASK) >> SHIFT;
+        chunks_y = (height + MASK) >> SHIFT;
+
+        chunks.clear();
+        chunks.resize(chunks_x * chunks_y);
+        background = value;
+    }
+
+    // chunks already holding cells keep them (refilled) so a rebuild can reuse them;
+    // every other chunk reads as the value without allocating
+    void fill(const T& value)
+    {
+        background = value;
+
+        for (auto& chunk : chunks)
+        {
+            chunk.palette.clear();
+            chunk.narrow.clear();
+            chunk.wide.clear();
+            if (!chunk.cells) continue;
+
+            for (int i = 0; i < CELLS; i++) chunk.cells[i] = value;
+        }
+    }
+
+    int get_width() const { return width; }
+    int get_height() const { return height; }
+    // what cells read as until written
+    const T& get_background() const { return background; }
+    int get_chunks_x() const { return chunks_x; }
+    int get_chunks_y() const { return chunks_y; }
+    int get_chunk_count() const { return chunks_x * chunks_y; }
+
+    bool in_bounds(int x, int y) const
+    {
+        return x >= 0 && y >= 0 && x < width && y < height;
+    }
+
+    int index(int x, int y) const
+    {
+        return y * width + x;
+    }
+
+    int chunk_of(int x, int y) const
+    {
+        return (y >> SHIFT) * chunks_x + (x >> SHIFT);
+    }
+
+    Column operator[](int x)
+    {
+        return Column{ this, x };
+    }
+
+    ConstColumn operator[](int x) const
+    {
+        return ConstColumn{ this, x };
+    }
+
+    // unpacks (or allocates) the chunk under the cell
+    T& at(int x, int y)
+    {
+        auto& chunk = chunks[chunk_of(x, y)];
+        if (!chunk.cells) unpack(chunk);
+
+        return chunk.cells[local(x, y)];
+    }
+
+    // reads without unpacking anything, in constant time whether the chunk is packed or not
+    T get(int x, int y) const
+    {
+        const auto& chunk = chunks[chunk_of(x, y)];
+        if (chunk.cells) return chunk.cells[local(x, y)];
+        if (chunk.palette.empty()) return background;
+        if (chunk.palette.size() == 1) return chunk.palette[0];
+
+        const int cell = local(x, y);
+        return chunk.palette[chunk.narrow.empty() ? chunk.wide[cell] : chunk.narrow[cell]];
+    }
+
+    bool is_resident(int chunk) const
+    {
+        return chunks[chunk].cells != nullptr;
+    }
+
+    // a chunk whose palette would take more room than its cells stays as it is
+    void compress(int index)
+    {
+        auto& chunk = chunks[index];
+        if (!chunk.cells) return;
+
+        if (slots.empty()) slots.assign(CELLS * 2, -1);
+        indices.resize(CELLS);
+        chunk.palette.clear();
+
+        for (int i = 0; i < CELLS; i++)
+        {
+            const T& value = chunk.cells[i];
+
+            // open addressing over palette entries; equal values always land on the same slot chain
+            size_t slot = hash(value) & (slots.size() - 1);
+            while (slots[slot] >= 0 && !(chunk.palette[slots[slot]] == value))
+                slot = (slot + 1) & (slots.size() - 1);
+
+            if (slots[slot] < 0)
+            {
+                slots[slot] = (int)chunk.palette.size();
+                chunk.palette.push_back(value);
+            }
+
+            indices[i] = (uint16_t)slots[slot];
+        }
+
+        for (auto& slot : slots) slot = -1;
+
+        const size_t index_size = chunk.palette.size() == 1 ? 0 : chunk.palette.size() <= 256 ? 1 : 2;
+        if (chunk.palette.size() * sizeof(T) + CELLS * index_size >= CELLS * sizeof(T))
+        {
+            std::vector<T>().swap(chunk.palette);
+            return;
+        }
+
+        // a chunk that never left the fill value needs no palette at all
+        if (chunk.palette.size() == 1 && chunk.palette[0] == background)
+            chunk.palette.clear();
+
+        if (index_size == 1)
+            chunk.narrow.assign(indices.begin(), indices.end());
+        else if (index_size == 2)
+            chunk.wide.assign(indices.begin(), indices.end());
+
+        chunk.palette.shrink_to_fit();
+        chunk.cells.reset();
+    }
+
+    // packs every resident chunk whose keep flag is off
+    void compress_except(const std::vector<bool>& keep)
+    {
+        for (int i = 0; i < get_chunk_count(); i++)
+        {
+            if (!keep[i]) compress(i);
+        }
+    }
+
+    size_t memory_used() const
+    {
+        size_t total = chunks.size() * sizeof(Chunk);
+        for (const auto& chunk : chunks)
+        {
+            if (chunk.cells) total += CELLS * sizeof(T);
+            total += chunk.palette.capacity() * sizeof(T) + chunk.narrow.capacity() + chunk.wide.capacity() * sizeof(uint16_t);
+        }
+
+        return total;
+    }
+
+private:
+    struct Chunk
+    {
+        std::unique_ptr<T[]> cells;
+        // packed: the distinct values, and each cell's index into them (bytes while there are
+        // at most 256, else 16 bits). one value needs no indices; no values reads as the background.
+        std::vector<T> palette;
+        std::vector<uint8_t> narrow;
+        std::vector<uint16_t> wide;
+    };
+
+    int width = 0;
+    int height = 0;
+    int chunks_x = 0;
+    int chunks_y = 0;
+    T background{};
+    std::vector<Chunk> chunks;
+
+    // compress() scratch, kept between calls
+    std::vector<int> slots;
+    std::vector<uint16_t> indices;
+
+    static int local(int x, int y)
+    {
+        return ((y & MASK) << SHIFT) | (x & MASK);
+    }
+
+    // equal cells must hash alike: bytes only when they are the value, else the cell's own hash()
+    static size_t hash(const T& value)
+    {
+        if constexpr (has_cell_hash<T>::value)
+            return value.hash();
+        else
+            return CellHash().add(&value, sizeof(T)).done();
+    }
+
+    void unpack(Chunk& chunk)
+    {
+        chunk.cells.reset(new T[CELLS]);
+
+        if (chunk.palette.size() <= 1)
+        {
+            const T value = chunk.palette.empty() ? background : chunk.palette[0];
+            for (int i = 0; i < CELLS; i++) chunk.cells[i] = value;
+        }
+        else if (!chunk.narrow.empty())
+        {
+            for (int i = 0; i < CELLS; i++) chunk.cells[i] = chunk.palette[chunk.narrow[i]];
+        }
+        else
+        {
+            for (int i = 0; i < CELLS; i++) chunk.cells[i] = chunk.palette[chunk.wide[i]];
+        }
+
+        std::vector<T>().swap(chunk.palette);
+        std::vector<uint8_t>().swap(chunk.narrow);
+        std::vector<uint16_t>().swap(chunk.wide);
+    }
+};
@@ -14,7 +14,7 @@ void MoveCommandInterpreter::interpret_command(CommandContext& context, CommandS
 	const auto cost_reduction = (speed.speed / ATTRIBUTE_SPEED_NORM) - 1;
 	context.cost -= cost_reduction;
 
-	if (level.map->isWalkable(signal.data.move.to_x, signal.data.move.to_y))
+	if (level.is_walkable(signal.data.move.to_x, signal.data.move.to_y))
 	{
 		auto& world_pos = AccessWorld_QueryComponent<WorldPosition>::get_component(context.subject);
 		
@@ -24,7 +24,7 @@ void MoveCommandInterpreter::interpret_command(CommandContext& context, CommandS
 		if (AccessWorld_QueryComponent<Player>::has_component(context.subject))
 		{
 			const auto& sight = AccessWorld_QueryComponent<Sight>::get_component(context.subject);
-			level.map->computeFov(world_pos.x, world_pos.y, sight.radius, true, FOV_RESTRICTIVE);
+			level.compute_fov(world_pos.x, world_pos.y, sight.radius);
 		}
 
         finish_command(context.cost);
@@ -38,7 +38,7 @@ void MoveCommandInterpreter::interpret_command(CommandContext& context, CommandS
 
 void UnlockCommandInterpreter::interpret_command(CommandContext& context, CommandSignal& signal)
 {   
-    TCODRandom* rng = TCODRandom::getInstance();
+    TCODRandom* rng = get_random().stream(RandomStream::Commands);
 
     if (rng->getFloat(0, 100) > signal.data.unlock.chance)
     {
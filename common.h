@@ -1,6 +1,7 @@
 #pragma once
 
 #include "config.h"
+#include "random.h"
 
 #include <entt/entt.hpp>
 #include <SDL2/SDL.h>
@@ -9,6 +10,12 @@
 #include <queue>
 #include <string>
 #include <memory>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
 
 using Color = TCOD_ColorRGB;
 
@@ -17,10 +24,10 @@ struct RGB
 {
     float r, g, b;
 
-    explicit RGB(float r, float g, float b)
+    constexpr explicit RGB(float r, float g, float b)
         : r(r), g(g), b(b) {}
 
-    RGB()
+    constexpr RGB()
         : r(0.0f), g(0.0f), b(0.0f) {}
 
     static RGB random()
@@ -28,50 +35,76 @@ struct RGB
         return RGB{ (float)(rand() % 255), (float)(rand() % 255), (float)(rand() % 255) };
     }
 
-    operator TCOD_ColorRGB()
+    constexpr operator TCOD_ColorRGB() const
     {
         return { (uint8_t)r, (uint8_t)g, (uint8_t)b };
     }
 };
 
-inline RGB operator""_rgb(const char* hexValue, size_t size)
+constexpr int hex_digit(char c)
+{
+    return c >= '0' && c <= '9' ? c - '0'
+        : c >= 'a' && c <= 'f' ? c - 'a' + 10
+        : c >= 'A' && c <= 'F' ? c - 'A' + 10
+        : 0;
+}
+
+// "#rrggbb"_rgb; a constant wherever it's used to initialise a constexpr
+constexpr RGB operator""_rgb(const char* hexValue, size_t size)
 {
     assert(size == 7);
-    int r, g, b;
-    sscanf_s(hexValue, "#%02x%02x%02x", &r, &g, &b);
     return RGB{
-        (r & 0xFF) / 1.0f,
-        (g & 0xFF) / 1.0f,
-        (b & 0xFF) / 1.0f
+        (float)(hex_digit(hexValue[1]) * 16 + hex_digit(hexValue[2])),
+        (float)(hex_digit(hexValue[3]) * 16 + hex_digit(hexValue[4])),
+        (float)(hex_digit(hexValue[5]) * 16 + hex_digit(hexValue[6]))
     };
 }
 
+// libtcod's HSV model (what HSL means throughout), with no branches so loops over it vectorise.
+// each channel falls off a ramp around its own sector of the hue wheel.
+inline TCOD_ColorRGB hsl_to_rgb(float h, float s, float l)
+{
+    s = std::min(std::max(s, 0.0f), 1.0f);
+    l = std::min(std::max(l, 0.0f), 1.0f);
+
+    h /= 60.0f;
+    h -= 6.0f * std::floor(h / 6.0f);
+
+    const auto channel = [h, s, l](float n) {
+        float k = n + h;
+        k -= k >= 6.0f ? 6.0f : 0.0f;
+        const float ramp = std::min(std::max(std::min(k, 4.0f - k), 0.0f), 1.0f);
+        return (uint8_t)((l - l * s * ramp) * 255.0f + 0.5f);
+    };
+
+    return TCOD_ColorRGB{ channel(5.0f), channel(3.0f), channel(1.0f) };
+}
 
 struct HSL
 {
     float h, s, l;
 
-    explicit HSL(float h, float s, float l)
+    constexpr explicit HSL(float h, float s, float l)
         : h(h), s(s), l(l)
     {}
 
-    HSL()
+    constexpr HSL()
         : h(0.0f), s(0.0f), l(0.0f)
     {}
 
-    HSL operator*(float dl)
+    HSL operator*(float dl) const
     {
         return HSL(h, s, l * dl);
     }
 
-    operator TCOD_ColorRGB()
+    operator TCOD_ColorRGB() const
     {
-        return TCOD_color_HSV(h, s, l);
+        return hsl_to_rgb(h, s, l);
     }
 
-    operator RGB()
+    operator RGB() const
     {
-        auto c = TCOD_color_HSV(h, s, l);
+        const auto c = hsl_to_rgb(h, s, l);
         return RGB{ (float)c.r, (float)c.g, (float)c.b };
     }
 };
@@ -85,10 +118,8 @@ struct LessTup {
 };
 
 template<typename T>
-void shuffle(std::vector<T>& ts)
+void shuffle(std::vector<T>& ts, TCODRandom* rng)
 {
-    TCODRandom* rng = TCODRandom::getInstance();
-
     std::priority_queue<std::tuple<T, int>, std::vector<std::tuple<T, int>>, LessTup<T>> pq;
     for (T t : ts)
     {
@@ -109,8 +140,8 @@ struct ScreenPosition
     int y;
 };
 
-enum KeyCode;
-enum MouseButton;
+enum KeyCode : int;
+enum MouseButton : int;
 
 struct KeyEvent final
 {
@@ -243,8 +274,8 @@ struct PeopleMapping
 
     Entity get_victim() { return people[PEOPLE_COUNT]; }
 
-    std::vector<Entity> get_all_places_shuffled();
-    std::vector<Entity> get_all_people_shuffled();
+    std::vector<Entity> get_all_places_shuffled(TCODRandom* rng);
+    std::vector<Entity> get_all_people_shuffled(TCODRandom* rng);
     std::vector<std::tuple<PersonEntity, PlaceEntity>> get_all_visiting_with(Entity visitor, bool with_victim = false);
     std::vector<std::tuple<PersonEntity, PlaceEntity>> get_all_working_with(Entity visitor, bool with_victim = false);
     std::vector<std::tuple<PersonEntity, PlaceEntity>> get_all_living_with(Entity visitor, bool with_victim = false);
@@ -401,8 +432,6 @@ struct WorldPositionHash
     }
 };
 
-#define TO_XY(x, y) ((int)x + MAP_WIDTH * (int)y)
-
 struct Level;
 
 using SocialInteraction = std::function<void(PeopleMapping&, int, Entity, bool)>;
@@ -410,7 +439,7 @@ using PlaceConstruction = std::function<void(PeopleMapping&, Level&, Name)>;
 
 struct XY
 {
-    int8_t x, y;
+    int16_t x, y;
 
     inline float distance(const XY& xy2) const
     {
@@ -484,12 +513,80 @@ struct PsychicEffect
     int range;
 };
 
+// what the player sees this frame: one bit per map cell for lookups, plus the cells in the order
+// they were marked for anything that walks over all of them
 struct PlayerFOV
 {
-    std::unordered_set<WorldPosition, WorldPositionHash> fields;
+    // forgets everything seen last frame; only reallocates when the map size changes
+    void reset(int width, int height)
+    {
+        if (width != this->width || height != this->height)
+        {
+            this->width = width;
+            this->height = height;
+            words = (width + 63) / 64;
+            bits.assign((size_t)words * height, 0);
+        }
+        else if (!bits.empty())
+        {
+            std::memset(bits.data(), 0, bits.size() * sizeof(uint64_t));
+        }
+
+        cells.clear();
+    }
+
+    void mark(int x, int y)
+    {
+        bits[(size_t)y * words + (x >> 6)] |= 1ull << (x & 63);
+        cells.push_back(WorldPosition{ x, y });
+    }
+
+    bool is_visible(int x, int y) const
+    {
+        if (x < 0 || y < 0 || x >= width || y >= height) return false;
+        return (bits[(size_t)y * words + (x >> 6)] >> (x & 63)) & 1;
+    }
+
+    bool is_visible(const WorldPosition& pt) const
+    {
+        return is_visible(pt.x, pt.y);
+    }
+
+    const std::vector<WorldPosition>& visible() const { return cells; }
+
+private:
+    int width = 0;
+    int height = 0;
+    int words = 0;
+    std::vector<uint64_t> bits;
+    std::vector<WorldPosition> cells;
+};
+
+// top-left world cell of the map viewport. levels bigger than the viewport scroll with the player.
+struct Camera
+{
+    int x = 0;
+    int y = 0;
+
+    // centres on the target, clamped so the viewport never leaves the map
+    void follow(const WorldPosition& target, int map_width, int map_height)
+    {
+        x = std::max(0, std::min(target.x - VIEW_WIDTH / 2, map_width - VIEW_WIDTH));
+        y = std::max(0, std::min(target.y - VIEW_HEIGHT / 2, map_height - VIEW_HEIGHT));
+    }
+
+    bool in_view(const WorldPosition& pos) const
+    {
+        return pos.x >= x && pos.y >= y && pos.x < x + VIEW_WIDTH && pos.y < y + VIEW_HEIGHT;
+    }
+
+    ScreenPosition to_screen(const WorldPosition& pos) const
+    {
+        return ScreenPosition{ pos.x - x, pos.y - y };
+    }
 };
 
-enum KeyCode
+enum KeyCode : int
 {
     KEY_UNKNOWN = 0,
 
@@ -882,7 +979,7 @@ enum KeyCode
     for array bounds */
 };
 
-enum MouseButton
+enum MouseButton : int
 {
     LEFT = SDL_BUTTON_LEFT,
     MIDDLE = SDL_BUTTON_MIDDLE,
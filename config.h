@@ -4,24 +4,55 @@
 #define SCREEN_WIDTH 80
 #define SCREEN_HEIGHT 52
 
-// map width/height
+// idle throttling: longest sleep while nothing is dirty, and the pace of slow animations
+#define IDLE_WAIT_MS 500
+#define MEMORY_FADE_FRAME_MS 100
+
+// a frame that changed nothing on screen skips present(), but still takes this long, as vsync would have made it
+#define PRESENT_FRAME_MS 16
+
+// default map width/height (--map-size picks another)
 #define MAP_WIDTH 80
 #define MAP_HEIGHT 44
 
+// the part of the map shown on screen
+#define VIEW_WIDTH 80
+#define VIEW_HEIGHT 44
+
+// levels are stored in chunks of (1 << CHUNK_SHIFT) tiles square; chunks further than
+// CHUNK_KEEP_RADIUS tiles from the player and every person are packed away
+#define CHUNK_SHIFT 6
+#define CHUNK_KEEP_RADIUS 48
+
 // room config
 #define ROOM_COUNT 20
 #define MIN_TILES_PER_ROOM 10
+// from this many rooms/blasts up, corridors come from one multi-source sweep instead of A* per edge
+#define CORRIDOR_SWEEP_MIN_POINTS 16
+
+// finished levels kept on disk for replaying seeds (--no-level-cache turns it off)
+#define LEVEL_CACHE_DIR "cache/levels"
+#define LEVEL_CACHE_ENTRIES 64
 
 // people and regions
 #define REGION_COUNT 6
 #define PEOPLE_COUNT 10
 #define EVENT_COUNT  50
+// poisson-disk spacing between region centres (shrinks when the map can't fit them) and between spawns
+#define REGION_SPACING 20
+// a region paints a disc of 5 tiles up to this radius around its centre
+#define REGION_RADIUS_MAX 7
+#define SPAWN_SPACING 2
 
 // actions
 #define ACTION_POINTS_PER_TURN 16
 #define ACTION_CANCELLED_COST 4
 #define ACTION_POINTS_PLAYER_BONUS 0
 
+// events
+#define EVENT_RECURSION_LIMIT 32
+#define EVENT_FLUSH_ROUNDS 1024
+
 // attributes
 #define ATTRIBUTE_SPEED_NORM 100
 #define ATTRIBUTE_SIGHT_NORM 30
@@ -0,0 +1,264 @@
+#include "corridors.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+void CorridorCarver::reset(int width, int height)
+{
+    this->width = width;
+    this->height = height;
+
+    const int size = width * height;
+    blocked_cells.assign(size, 0);
+    cost.resize(size);
+    parent.resize(size);
+    origin.resize(size);
+
+    // a resize invalidates the stamps, so start them over
+    visited.assign(size, 0);
+    generation = 0;
+
+    // a cell is only pushed again when a cheaper way to it turns up, which a grid this size
+    // rarely allows more than a few times over
+    open.reserve(size);
+}
+
+void CorridorCarver::next_generation()
+{
+    generation++;
+    if (generation == 0)
+    {
+        std::fill(visited.begin(), visited.end(), 0);
+        generation = 1;
+    }
+
+    open.clear();
+}
+
+int CorridorCarver::neighbours(int cell, int out[8], float step[8]) const
+{
+    static constexpr int dx[8]{ 0, 0, -1, 1, -1, -1, 1, 1 };
+    static constexpr int dy[8]{ -1, 1, 0, 0, -1, 1, -1, 1 };
+
+    const int x = cell % width;
+    const int y = cell / width;
+    const int directions = diagonal ? 8 : 4;
+
+    int count = 0;
+    for (int d = 0; d < directions; d++)
+    {
+        const int nx = x + dx[d];
+        const int ny = y + dy[d];
+        if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+
+        const int next = ny * width + nx;
+        if (blocked_cells[next]) continue;
+
+        out[count] = next;
+        step[count] = d < 4 ? 1.0f : diagonal_cost;
+        count++;
+    }
+
+    return count;
+}
+
+float CorridorCarver::heuristic(int cell, int goal) const
+{
+    const int dx = std::abs(cell % width - goal % width);
+    const int dy = std::abs(cell / width - goal / width);
+
+    if (!diagonal) return (float)(dx + dy);
+
+    // octile distance, admissible as long as a diagonal costs no more than two straight steps
+    const int straight = std::abs(dx - dy);
+    const int diagonals = std::min(dx, dy);
+    return straight + diagonals * std::min(diagonal_cost, 2.0f);
+}
+
+void CorridorCarver::push(float priority, int cell)
+{
+    open.push_back(OpenNode{ priority, cell });
+    std::push_heap(open.begin(), open.end(), [](const OpenNode& a, const OpenNode& b) {
+        return a.priority != b.priority ? a.priority > b.priority : a.cell > b.cell;
+    });
+}
+
+int CorridorCarver::pop()
+{
+    std::pop_heap(open.begin(), open.end(), [](const OpenNode& a, const OpenNode& b) {
+        return a.priority != b.priority ? a.priority > b.priority : a.cell > b.cell;
+    });
+
+    const int cell = open.back().cell;
+    open.pop_back();
+    return cell;
+}
+
+void CorridorCarver::walk_back(int cell, std::vector<WorldPosition>& cells) const
+{
+    // the root (a search start) has no parent and is left out
+    while (parent[cell] >= 0)
+    {
+        cells.push_back(WorldPosition{ cell % width, cell / width });
+        cell = parent[cell];
+    }
+}
+
+bool CorridorCarver::find_path(WorldPosition from, WorldPosition to, std::vector<WorldPosition>& cells)
+{
+    const int start = from.y * width + from.x;
+    const int goal = to.y * width + to.x;
+
+    // like the map it replaces, a blocked goal can't be reached; a blocked start is fine
+    if (blocked_cells[goal] && goal != start) return false;
+
+    next_generation();
+
+    cost[start] = 0.0f;
+    parent[start] = -1;
+    visited[start] = generation;
+    push(heuristic(start, goal), start);
+
+    int next[8];
+    float step[8];
+
+    while (!open.empty())
+    {
+        const int cell = pop();
+        if (cell == goal)
+        {
+            walk_back(goal, cells);
+            return true;
+        }
+
+        const int count = neighbours(cell, next, step);
+        for (int i = 0; i < count; i++)
+        {
+            const float through = cost[cell] + step[i];
+            const int n = next[i];
+
+            if (visited[n] == generation && cost[n] <= through) continue;
+
+            visited[n] = generation;
+            cost[n] = through;
+            parent[n] = cell;
+            push(through + heuristic(n, goal), n);
+        }
+    }
+
+    return false;
+}
+
+int CorridorCarver::edge_between(int a, int b) const
+{
+    for (int k = edge_start[a]; k < edge_start[a + 1]; k++)
+    {
+        if (edge_links[k].first == b) return edge_links[k].second;
+    }
+
+    return -1;
+}
+
+void CorridorCarver::find_tree_paths(const std::vector<WorldPosition>& points, const std::vector<SpanningEdge>& edges, std::vector<WorldPosition>& cells)
+{
+    const int size = width * height;
+
+    // tree edges by endpoint, so a pair of regions finds its edge by scanning a handful of links
+    edge_start.assign(points.size() + 1, 0);
+    for (const auto& edge : edges)
+    {
+        edge_start[edge.a + 1]++;
+        edge_start[edge.b + 1]++;
+    }
+    for (size_t i = 1; i < edge_start.size(); i++) edge_start[i] += edge_start[i - 1];
+
+    edge_links.resize(edges.size() * 2);
+    edge_fill.assign(edge_start.begin(), edge_start.end() - 1);
+    for (int e = 0; e < (int)edges.size(); e++)
+    {
+        edge_links[edge_fill[edges[e].a]++] = { edges[e].b, e };
+        edge_links[edge_fill[edges[e].b]++] = { edges[e].a, e };
+    }
+
+    bridges.assign(edges.size(), Bridge{});
+
+    next_generation();
+
+    for (int i = 0; i < (int)points.size(); i++)
+    {
+        const int cell = points[i].y * width + points[i].x;
+        if (visited[cell] == generation) continue;
+
+        visited[cell] = generation;
+        cost[cell] = 0.0f;
+        parent[cell] = -1;
+        origin[cell] = i;
+        push(0.0f, cell);
+    }
+
+    int next[8];
+    float step[8];
+
+    while (!open.empty())
+    {
+        const int cell = pop();
+
+        const int count = neighbours(cell, next, step);
+        for (int i = 0; i < count; i++)
+        {
+            const float through = cost[cell] + step[i];
+            const int n = next[i];
+
+            if (visited[n] == generation && cost[n] <= through) continue;
+
+            visited[n] = generation;
+            cost[n] = through;
+            parent[n] = cell;
+            origin[n] = origin[cell];
+            push(through, n);
+        }
+    }
+
+    // every step between two regions is a candidate crossing for the tree edge joining them
+    for (int cell = 0; cell < size; cell++)
+    {
+        if (visited[cell] != generation) continue;
+
+        const int count = neighbours(cell, next, step);
+        for (int i = 0; i < count; i++)
+        {
+            const int n = next[i];
+            if (visited[n] != generation || origin[n] == origin[cell]) continue;
+
+            const int edge = edge_between(origin[cell], origin[n]);
+            if (edge < 0) continue;
+
+            const float through = cost[cell] + step[i] + cost[n];
+            if (through < bridges[edge].cost)
+            {
+                bridges[edge] = Bridge{ through, cell, n };
+            }
+        }
+    }
+
+    // each half runs back to its own source; fallbacks go last, as they reuse the sweep's buffers
+    unbridged.clear();
+    for (int e = 0; e < (int)edges.size(); e++)
+    {
+        const auto& bridge = bridges[e];
+        if (bridge.from < 0)
+        {
+            unbridged.push_back(e);
+            continue;
+        }
+
+        walk_back(bridge.from, cells);
+        walk_back(bridge.to, cells);
+    }
+
+    for (const int e : unbridged)
+    {
+        find_path(points[edges[e].a], points[edges[e].b], cells);
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "common.h"
+#include "spanning.h"
+
+// finds corridor paths over a row-major grid of open/blocked cells. every buffer lives as long
+// as the carver, so carving a whole level allocates only when the grid or the tree grows.
+struct CorridorCarver
+{
+    bool diagonal = false;
+    float diagonal_cost = 1.41f;
+
+    // resizes to width x height and opens every cell
+    void reset(int width, int height);
+
+    void block(int x, int y, bool blocked = true)
+    {
+        blocked_cells[y * width + x] = blocked ? 1 : 0;
+    }
+
+    // A* from one cell to another; appends every cell after `from` up to and including `to`
+    bool find_path(WorldPosition from, WorldPosition to, std::vector<WorldPosition>& cells);
+
+    // one multi-source sweep from every point at once; each tree edge then becomes the cheapest
+    // path across the border between its two endpoints' regions. edges whose regions never
+    // touch fall back to find_path. appends the cells of every corridor.
+    void find_tree_paths(const std::vector<WorldPosition>& points, const std::vector<SpanningEdge>& edges, std::vector<WorldPosition>& cells);
+
+private:
+    struct OpenNode
+    {
+        float priority;
+        int cell;
+    };
+
+    struct Bridge
+    {
+        float cost = std::numeric_limits<float>::max();
+        int from = -1;
+        int to = -1;
+    };
+
+    int width = 0;
+    int height = 0;
+
+    std::vector<uint8_t> blocked_cells;
+    std::vector<float> cost;
+    std::vector<int> parent;
+    std::vector<int> origin;
+    std::vector<uint32_t> visited;
+    uint32_t generation = 0;
+    std::vector<OpenNode> open;
+
+    std::vector<int> edge_start;
+    std::vector<int> edge_fill;
+    std::vector<std::pair<int, int>> edge_links;
+    std::vector<Bridge> bridges;
+    std::vector<int> unbridged;
+
+    int neighbours(int cell, int out[8], float step[8]) const;
+    float heuristic(int cell, int goal) const;
+    void push(float priority, int cell);
+    int pop();
+    void next_generation();
+    void walk_back(int cell, std::vector<WorldPosition>& cells) const;
+    int edge_between(int a, int b) const;
+};
@@ -1,5 +1,6 @@
 #include "debug.h"
 
+#include <algorithm>
 #include <sstream>
 
 #include <yaml-cpp/yaml.h>
@@ -20,15 +21,15 @@ void Debug_TurnOrderSystem::activate()
 		//                          34567890123456789012345678901234567890
 		str({ 3 , line }, "NAME       AP   SPD   HP            ", "#b0b0ff"_rgb);
 		line++;
-		for (auto&& [e, ap, s, h] : AccessWorld_QueryAllEntitiesWith<ActionPoints, Speed, Health>::query().each())
+		for (auto&& [e, ap, s, h] : AccessWorld_QueryAllEntitiesWith<const ActionPoints, const Speed, const Health>::query().each())
 		{
 			auto color = line % 2 == 0 ? "#e0e0ff"_rgb : "#ffffff"_rgb;
 			if (is_valid(e))
 			{
-				if (AccessWorld_QueryComponent<Name>::has_component(e))
+				if (AccessWorld_QueryComponent<const Name>::has_component(e))
 				{
 					std::stringstream stream;
-					stream << std::left << std::setw(10) << std::setfill(' ') << AccessWorld_QueryComponent<Name>::get_component(e).name;
+					stream << std::left << std::setw(10) << std::setfill(' ') << AccessWorld_QueryComponent<const Name>::get_component(e).name;
 					str({ 3, line }, stream.str(), color);
 					
 					stream.clear(); stream.str("");
@@ -49,6 +50,87 @@ void Debug_TurnOrderSystem::activate()
 	}
 }
 
+void Debug_ProfilerSystem::react_to_event(KeyEvent& signal)
+{
+	if (signal.key == KeyCode::KEY_F4)
+	{
+		visible = !visible;
+		if (visible)
+		{
+			get_profiler().reset();
+			AccessWorld_UseUnique<EventStats>::access_unique() = EventStats{};
+			AccessWorld_UseUnique<PresentStats>::access_unique() = PresentStats{};
+		}
+	}
+	else if (signal.key == KeyCode::KEY_F5)
+	{
+		if (get_profiler().dump_chrome_trace("trace.json"))
+			printf("Profiler trace written to trace.json\n");
+	}
+}
+
+void Debug_ProfilerSystem::activate()
+{
+	if (visible)
+	{
+		const auto stats = get_profiler().get_stats();
+
+		std::vector<const ProfileStat*> rows;
+		for (const auto& stat : stats)
+		{
+			if (stat.samples > 0)
+				rows.push_back(&stat);
+		}
+
+		std::sort(rows.begin(), rows.end(), [](const ProfileStat* a, const ProfileStat* b) { return a->avg_ms() > b->avg_ms(); });
+
+		int line = 2;
+		box({ 1, line }, 72, (int)rows.size() + 3, "#ffffff"_rgb, "#000000"_rgb);
+		str({ 2, line }, "SYSTEM                                       LAST     AVG      MAX", "#b0b0ff"_rgb);
+		line++;
+
+		for (const auto* stat : rows)
+		{
+			if (line >= SCREEN_HEIGHT - 1) break;
+
+			auto color = line % 2 == 0 ? "#e0e0ff"_rgb : "#ffffff"_rgb;
+
+			std::stringstream stream;
+			stream << std::left << std::setw(44) << std::setfill(' ') << stat->name.substr(0, 43);
+			str({ 2, line }, stream.str(), color);
+
+			stream.clear(); stream.str("");
+			stream << std::fixed << std::setprecision(3) << stat->last_ms;
+			str({ 47, line }, stream.str(), color);
+
+			stream.clear(); stream.str("");
+			stream << std::fixed << std::setprecision(3) << stat->avg_ms();
+			str({ 56, line }, stream.str(), color);
+
+			stream.clear(); stream.str("");
+			stream << std::fixed << std::setprecision(3) << stat->max_ms;
+			str({ 65, line }, stream.str(), color);
+
+			line++;
+		}
+
+		const auto& events = AccessWorld_UseUnique<EventStats>::access_unique();
+
+		std::stringstream stream;
+		stream << "EVENTS " << events.triggered << " TRIGGERED  " << events.deferred << " DEFERRED  " 
+			<< events.flushed << " FLUSHED  DEPTH " << events.max_depth;
+		str({ 2, line }, stream.str(), "#b0b0ff"_rgb);
+		line++;
+
+		const auto& present = AccessWorld_UseUnique<PresentStats>::access_unique();
+
+		stream.clear(); stream.str("");
+		stream << "PRESENT " << present.presented << " DRAWN  " << present.skipped << " SKIPPED  "
+			<< present.dirty_cells << " CELLS CHANGED";
+		str({ 2, line }, stream.str(), "#b0b0ff"_rgb);
+	}
+}
+
 void Debug_ReloadConfigSystem::react_to_event(KeyEvent& signal)
 {
 	if (signal.key == KeyCode::KEY_F2)
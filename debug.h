@@ -8,9 +8,22 @@ struct Debug_TurnOrderSystem
 	, public AccessConsole
 	, public AccessWorld_CheckValidity
 	, public AccessEvents_Listen<KeyEvent>
-	, public AccessWorld_UseUnique<CurrentInTurn>
-	, public AccessWorld_QueryAllEntitiesWith<ActionPoints, Speed, Health>
-	, public AccessWorld_QueryComponent<Name>
+	, public AccessWorld_UseUnique<const CurrentInTurn>
+	, public AccessWorld_QueryAllEntitiesWith<const ActionPoints, const Speed, const Health>
+	, public AccessWorld_QueryComponent<const Name>
+{
+	bool visible = false;
+
+	void react_to_event(KeyEvent& signal) override;
+	void activate() override;
+};
+
+struct Debug_ProfilerSystem
+	: public RuntimeSystem
+	, public AccessConsole
+	, public AccessEvents_Listen<KeyEvent>
+	, public AccessWorld_UseUnique<EventStats>
+	, public AccessWorld_UseUnique<PresentStats>
 {
 	bool visible = false;
 
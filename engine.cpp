@@ -9,12 +9,21 @@
 
 using namespace std::chrono;
 
-PoirogueEngine::PoirogueEngine()
+PoirogueEngine::PoirogueEngine(bool headless)
     : engine_running{ true }
+    , headless{ headless }
 {
     PoirogueEngine::Instance = this;
 
+    present_profile_scope = get_profiler().register_scope("present");
+    flush_profile_scope = get_profiler().register_scope("flush_events");
+
     tcod_console = tcod::Console{ SCREEN_WIDTH, SCREEN_HEIGHT };
+    presented_console = tcod::Console{ SCREEN_WIDTH, SCREEN_HEIGHT };
+
+    // headless runs never open a window: no SDL video, no context, no tileset
+    if (headless) return;
+
     auto params = TCOD_ContextParams{};
 
     params.tcod_version = TCOD_COMPILEDVERSION;
@@ -33,85 +42,208 @@ PoirogueEngine::PoirogueEngine()
     tcod_context = tcod::Context(params);
 
     SDL_ShowCursor(false);
+    tick_epoch = SDL_GetTicks();
 }
 
 PoirogueEngine::~PoirogueEngine()
 {
-    SDL_ShowCursor(true);
+    if (!headless)
+        SDL_ShowCursor(true);
 }
 
 void PoirogueEngine::restart_game()
 {
+    // anything still queued refers to entities that are about to go away
+    entt_events.clear();
+    queued_events = 0;
+
     entt_world.clear();
+    frame_dirty = true;
+    force_present = true;
 
     for (auto& system : one_offs_systems)
     {
+        ProfileScope scope(system->profile_scope);
         system->activate();
     }
+
+    flush_events();
 }
 
 void PoirogueEngine::start_frame()
 {
+    const auto now = SDL_GetTicks();
+    frames_elapsed = headless ? 1.0f : std::max(1.0f, (now - last_frame_at) * 60.0f / 1000.0f);
+    last_frame_at = now;
+
+    // systems re-request any animation they still need while they draw this frame
+    frame_dirty = false;
+    next_frame_at = NO_FRAME_REQUESTED;
+
     TCOD_console_clear(tcod_console.get());
 }
 
+bool PoirogueEngine::frame_pending() const
+{
+    return headless || !idle_throttle || frame_dirty || SDL_GetTicks() >= next_frame_at;
+}
+
+void PoirogueEngine::set_idle_throttle(bool throttle)
+{
+    idle_throttle = throttle;
+}
+
 void PoirogueEngine::poll_events()
 {
-    SDL_Event event;    
-    while (SDL_PollEvent(&event)) {
-        tcod_context.convert_event_coordinates(event);
-        switch (event.type) {
-        case SDL_QUIT:
-            engine_running = false;
-            break;
-
-        case SDL_KEYUP:
-            entt_events.trigger<KeyEvent>(KeyEvent
-                {
-                    (KeyCode)event.key.keysym.scancode,
-                    (event.key.keysym.mod & SDL_Keymod::KMOD_LCTRL) == SDL_Keymod::KMOD_LCTRL,
-                    (event.key.keysym.mod & SDL_Keymod::KMOD_LALT) == SDL_Keymod::KMOD_LALT,
-                    (event.key.keysym.mod & SDL_Keymod::KMOD_LSHIFT) == SDL_Keymod::KMOD_LSHIFT,
-                });
-            break;
-
-        case SDL_MOUSEBUTTONDOWN:
-            entt_events.trigger<MouseEvent>(MouseEvent
-                {
-                    true,
-                    (MouseButton)event.button.button,
-                    event.button.x,
-                    event.button.y
-                });
-            break;
-
-        case SDL_MOUSEBUTTONUP:
-            mouse_buttons[event.button.button] = true;
-            entt_events.trigger<MouseEvent>(MouseEvent
-                {
-                    false,
-                    (MouseButton)event.button.button,
-                    event.button.x,
-                    event.button.y
-                });
-            break;
-
-        case SDL_MOUSEMOTION:
-            mouse_position.x = event.motion.x;
-            mouse_position.y = event.motion.y;
-            break;
-
-        default:
-            entt_events.trigger<WindowEvent>(WindowEvent{ event });
-            break;
+    SDL_Event event;
+
+    // nothing to draw: sleep until input arrives or the next animation frame is due
+    if (!headless && idle_throttle && !frame_dirty)
+    {
+        const auto now = SDL_GetTicks();
+        const auto wait = next_frame_at == NO_FRAME_REQUESTED ? IDLE_WAIT_MS 
+            : (next_frame_at > now ? std::min<Uint32>(next_frame_at - now, IDLE_WAIT_MS) : 0);
+
+        if (wait > 0 && SDL_WaitEventTimeout(&event, (int)wait))
+        {
+            handle_event(event);
         }
     }
+
+    while (!headless && SDL_PollEvent(&event)) {
+        handle_event(event);
+    }
+
+    flush_events();
+}
+
+void PoirogueEngine::handle_event(SDL_Event& event)
+{
+    frame_dirty = true;
+
+    tcod_context.convert_event_coordinates(event);
+    switch (event.type) {
+    case SDL_QUIT:
+        engine_running = false;
+        break;
+
+    case SDL_KEYUP:
+        trigger_event<KeyEvent>(KeyEvent
+            {
+                (KeyCode)event.key.keysym.scancode,
+                (event.key.keysym.mod & SDL_Keymod::KMOD_LCTRL) == SDL_Keymod::KMOD_LCTRL,
+                (event.key.keysym.mod & SDL_Keymod::KMOD_LALT) == SDL_Keymod::KMOD_LALT,
+                (event.key.keysym.mod & SDL_Keymod::KMOD_LSHIFT) == SDL_Keymod::KMOD_LSHIFT,
+            });
+        break;
+
+    case SDL_MOUSEBUTTONDOWN:
+        trigger_event<MouseEvent>(MouseEvent
+            {
+                true,
+                (MouseButton)event.button.button,
+                event.button.x,
+                event.button.y
+            });
+        break;
+
+    case SDL_MOUSEBUTTONUP:
+        mouse_buttons[event.button.button] = true;
+        trigger_event<MouseEvent>(MouseEvent
+            {
+                false,
+                (MouseButton)event.button.button,
+                event.button.x,
+                event.button.y
+            });
+        break;
+
+    case SDL_MOUSEMOTION:
+        mouse_position.x = event.motion.x;
+        mouse_position.y = event.motion.y;
+        break;
+
+    default:
+        // exposes and resizes lose the window contents, so the next frame goes out whole
+        force_present = true;
+        trigger_event<WindowEvent>(WindowEvent{ event });
+        break;
+    }
+}
+
+static bool same_tile(const TCOD_ConsoleTile& a, const TCOD_ConsoleTile& b)
+{
+    return a.ch == b.ch
+        && a.fg.r == b.fg.r && a.fg.g == b.fg.g && a.fg.b == b.fg.b && a.fg.a == b.fg.a
+        && a.bg.r == b.bg.r && a.bg.g == b.bg.g && a.bg.b == b.bg.b && a.bg.a == b.bg.a;
+}
+
+int PoirogueEngine::diff_console()
+{
+    const auto* current = tcod_console.get();
+    const auto* previous = presented_console.get();
+
+    int dirty_cells = 0;
+    for (int i = 0; i < current->elements; i++)
+    {
+        if (!same_tile(current->tiles[i], previous->tiles[i])) dirty_cells++;
+    }
+
+    return dirty_cells;
 }
 
-void PoirogueEngine::end_frame()
+void PoirogueEngine::present()
 {
+    ProfileScope scope(present_profile_scope);
+
+    auto& stats = get_res<PresentStats>();
+    stats.dirty_cells = diff_console();
+
+    // nothing on screen moved: the window still shows exactly this frame. presenting was
+    // also what waited for vsync, so the frame's time is waited out here instead.
+    if (stats.dirty_cells == 0 && !force_present)
+    {
+        stats.skipped++;
+
+        const auto since = SDL_GetTicks() - last_present_at;
+        if (since < PRESENT_FRAME_MS)
+            SDL_Delay(PRESENT_FRAME_MS - since);
+
+        last_present_at = SDL_GetTicks();
+        return;
+    }
+
+    // the context's renderer already redraws only the tiles that differ from its own cache,
+    // so the whole console goes out; the diff decides whether it goes out at all
     tcod_context.present(tcod_console);
-    entt_events.trigger<Tick>(Tick{});
+    last_present_at = SDL_GetTicks();
+    stats.presented++;
+
+    const auto* current = tcod_console.get();
+    std::copy(current->tiles, current->tiles + current->elements, presented_console.get()->tiles);
+    force_present = false;
+}
+
+void PoirogueEngine::end_frame(bool drawn)
+{
+    if (!headless && drawn)
+    {
+        present();
+    }
+
+    // one Tick per 60Hz frame that went by, drawn or idle, so AccessTick timers keep the pace they had under vsync
+    Uint64 ticks_due = ticks_sent + 1;
+    if (!headless)
+    {
+        ticks_due = (Uint64)(SDL_GetTicks() - tick_epoch) * 60 / 1000;
+    }
+
+    for (; ticks_sent < ticks_due; ticks_sent++)
+    {
+        trigger_event<Tick>(Tick{});
+    }
+
+    flush_events();
 
     for (int i = 0; i < 4; i++)
     {
@@ -123,8 +255,27 @@ void PoirogueEngine::run_systems()
 {
     for (auto& system : runtime_systems)
     {        
+        ProfileScope scope(system->profile_scope);
         system->activate();
     }
+
+    flush_events();
+}
+
+void PoirogueEngine::flush_events()
+{
+    if (queued_events == 0) return;
+
+    ProfileScope scope(flush_profile_scope);
+    frame_dirty = true;
+
+    // every update() delivers the queued events type by type; handlers may queue more for the next round
+    for (int round = 0; queued_events > 0 && round < EVENT_FLUSH_ROUNDS; round++)
+    {
+        get_res<EventStats>().flushed += queued_events;
+        queued_events = 0;
+        entt_events.update();
+    }
 }
 
 PoirogueEngine::operator bool() const
@@ -132,6 +283,11 @@ PoirogueEngine::operator bool() const
     return engine_running;
 }
 
+bool PoirogueEngine::is_headless() const
+{
+    return headless;
+}
+
 void PoirogueEngine::quit()
 {
     engine_running = false;
@@ -4,14 +4,20 @@
 #include <libtcod.h>
 #include <entt/entt.hpp>
 
+#include <algorithm>
+#include <type_traits>
+#include <typeinfo>
 #include <unordered_map>
 #include <vector>
 
 #include "utils.h"
 #include "common.h"
+#include "profiler.h"
 
 struct System 
 {
+    int profile_scope = -1;
+
     virtual void activate() {}
 };
 
@@ -25,18 +31,45 @@ struct RuntimeSystem : public System
     virtual void activate() {}
 };
 
+template<typename T>
+T& get_res()
+{
+    static T unique_resource;
+    return unique_resource;
+}
+
+struct EventStats
+{
+    long triggered = 0;
+    long deferred = 0;
+    long flushed = 0;
+    int max_depth = 0;
+};
+
+struct PresentStats
+{
+    long presented = 0;
+    long skipped = 0;
+    int dirty_cells = 0;
+};
+
 struct PoirogueEngine final
 {
-	PoirogueEngine();
+	PoirogueEngine(bool headless = false);
 	~PoirogueEngine();
 	
 	void restart_game();
 	void start_frame();
     void poll_events();
-	void end_frame();
+	void end_frame(bool drawn = true);
 	void run_systems();
+	void flush_events();
+	bool frame_pending() const;
 	
 	operator bool() const;
+	bool is_headless() const;
+
+	void set_idle_throttle(bool throttle);
 	
 	void quit();
 
@@ -49,6 +82,7 @@ public:
     std::shared_ptr<T> add_one_off_system()
     {
         std::shared_ptr<T> ptr{ new T };
+        ptr->profile_scope = get_profiler().register_scope(clean_type_name(typeid(T).name()));
         one_offs_systems.push_back(ptr);
 
         return ptr;
@@ -58,30 +92,84 @@ public:
     std::shared_ptr<T> add_runtime_system()
     {
         std::shared_ptr<T> ptr{ new T };
+        ptr->profile_scope = get_profiler().register_scope(clean_type_name(typeid(T).name()));
         runtime_systems.push_back(ptr);
 
         return ptr;
     }
 
+    template<typename T>
+    void trigger_event(T signal)
+    {
+        // past the limit the chain is cut and picked up again at the next drain point
+        if (event_depth >= EVENT_RECURSION_LIMIT)
+        {
+            enqueue_event<T>(std::move(signal));
+            return;
+        }
+
+        auto& stats = get_res<EventStats>();
+        stats.triggered++;
+
+        event_depth++;
+        stats.max_depth = std::max(stats.max_depth, event_depth);
+        entt_events.trigger<T>(std::move(signal));
+        event_depth--;
+    }
+
+    template<typename T>
+    void enqueue_event(T signal)
+    {
+        get_res<EventStats>().deferred++;
+        queued_events++;
+        entt_events.enqueue<T>(std::move(signal));
+    }
+
 protected:
 	ecs::registry entt_world;
 	ecs::dispatcher entt_events;
+	int event_depth = 0;
+	long queued_events = 0;
 
 	tcod::Console tcod_console;
 	tcod::Context tcod_context;
 
+	// the last frame that actually reached the window, and what changed since
+	tcod::Console presented_console;
+	bool force_present = true;
+	Uint32 last_present_at = 0;
+
 	static PoirogueEngine* Instance;
 
 private:
+    static constexpr Uint32 NO_FRAME_REQUESTED = 0xFFFFFFFF;
+
     bool mouse_buttons[4] { false, false, false, false };
 
     ScreenPosition mouse_position;
 	bool engine_running;
+	bool headless;
+	int present_profile_scope;
+	int flush_profile_scope;
+
+	bool idle_throttle = true;
+	bool frame_dirty = true;
+	Uint32 next_frame_at = NO_FRAME_REQUESTED;
+	Uint32 last_frame_at = 0;
+	Uint32 tick_epoch = 0;
+	Uint64 ticks_sent = 0;
+	float frames_elapsed = 1.0f;
+
+	void handle_event(SDL_Event& event);
+	int diff_console();
+	void present();
     
     friend struct AccessConsole;
 
     friend struct AccessWorld_CheckValidity;
     friend struct AccessResource_Mouse;
+    friend struct AccessResource_Headless;
+    friend struct AccessResource_Redraw;
 
     template<typename T>
     friend struct AccessWorld_UseUnique;
@@ -136,6 +224,29 @@ struct AccessConsole : public Access
     void ch(const ScreenPosition& pt, std::string_view text);
     void bg(const ScreenPosition& pt, RGB color);
     void fg(const ScreenPosition& pt, RGB color);
+
+    // for per-cell passes like the map: glyph and colours go straight into the console's tile,
+    // with no strings or utf-8 on the way. the background stays as it is unless one is given.
+    void put(const ScreenPosition& pt, int glyph, TCOD_ColorRGB fg)
+    {
+        auto& console = PoirogueEngine::Instance->tcod_console;
+        if (!console.in_bounds({ pt.x, pt.y })) return;
+
+        auto& tile = console.at({ pt.x, pt.y });
+        tile.ch = glyph;
+        tile.fg = TCOD_ColorRGBA{ fg.r, fg.g, fg.b, 255 };
+    }
+
+    void put(const ScreenPosition& pt, int glyph, TCOD_ColorRGB fg, TCOD_ColorRGB bg)
+    {
+        auto& console = PoirogueEngine::Instance->tcod_console;
+        if (!console.in_bounds({ pt.x, pt.y })) return;
+
+        auto& tile = console.at({ pt.x, pt.y });
+        tile.ch = glyph;
+        tile.fg = TCOD_ColorRGBA{ fg.r, fg.g, fg.b, 255 };
+        tile.bg = TCOD_ColorRGBA{ bg.r, bg.g, bg.b, 255 };
+    }
 };
 
 struct AccessWorld_CheckValidity : public Access
@@ -169,19 +280,42 @@ struct AccessResource_Mouse : public Access
     }
 };
 
-template<typename T>
-T& get_res()
+struct AccessResource_Headless : public Access
 {
-    static T unique_resource;
-    return unique_resource;
-}
+    bool is_headless() const
+    {
+        return PoirogueEngine::Instance->headless;
+    }
+};
+
+struct AccessResource_Redraw : public Access
+{
+    // something changed outside of input and events; draw the next frame
+    void request_redraw()
+    {
+        PoirogueEngine::Instance->frame_dirty = true;
+    }
+
+    // an animation is running; draw again in delay_ms even if nothing else happens
+    void request_animation_frame(Uint32 delay_ms = 0)
+    {
+        auto& engine = *PoirogueEngine::Instance;
+        engine.next_frame_at = std::min(engine.next_frame_at, SDL_GetTicks() + delay_ms);
+    }
+
+    // how many 60Hz frames the last drawn frame stands for, for animations that step per frame
+    float frames_elapsed() const
+    {
+        return PoirogueEngine::Instance->frames_elapsed;
+    }
+};
 
 template<typename T>
 struct AccessWorld_UseUnique : public Access
 {
     T& access_unique()
     {        
-        return get_res<T>();
+        return get_res<std::remove_const_t<T>>();
     }
 };
 
@@ -204,7 +338,6 @@ struct AccessWorld_ModifyWorld : public Access
 
 struct AccessWorld_ModifyEntity : public Access
 {
-
     template<typename T>
     void add_tag_component(Entity entity)
     {
@@ -229,12 +362,12 @@ struct AccessWorld_QueryComponent : public Access
 {    
     bool has_component(Entity e)
     {
-        return PoirogueEngine::Instance->entt_world.all_of<T>(e);
+        return PoirogueEngine::Instance->entt_world.all_of<std::remove_const_t<T>>(e);
     }
     
     T& get_component(Entity e)
     {
-        return PoirogueEngine::Instance->entt_world.get<T>(e);
+        return PoirogueEngine::Instance->entt_world.get<std::remove_const_t<T>>(e);
     }
 };
 
@@ -252,12 +385,18 @@ struct AccessEvents_Emit : public Access
 {
     void emit_event()
     {
-        PoirogueEngine::Instance->entt_events.trigger<T>();
+        PoirogueEngine::Instance->trigger_event<T>(T{});
     }
 
     void emit_event(T signal)
     {
-        PoirogueEngine::Instance->entt_events.trigger<T>(std::forward<T>(signal));
+        PoirogueEngine::Instance->trigger_event<T>(std::move(signal));
+    }
+
+    // delivered at the engine's next drain point instead of on the current call stack
+    void enqueue_event(T signal)
+    {
+        PoirogueEngine::Instance->enqueue_event<T>(std::move(signal));
     }
 };
 
@@ -266,10 +405,26 @@ struct AccessEvents_Listen : public Access
 {
 	AccessEvents_Listen()
 	{
-		PoirogueEngine::Instance->entt_events.sink<T>().connect<&AccessEvents_Listen<T>::react_to_event>(this);
+		PoirogueEngine::Instance->entt_events.sink<T>().connect<&AccessEvents_Listen<T>::dispatch_event>(this);
 	}
 
 	virtual void react_to_event(T& signal) = 0;
+
+private:
+	int handler_profile_scope = -1;
+
+	void dispatch_event(T& signal)
+	{
+		// the dynamic type is only known once construction is over, so the scope is named lazily
+		if (handler_profile_scope < 0)
+		{
+			handler_profile_scope = get_profiler().register_scope(
+				clean_type_name(typeid(*this).name()) + "::" + clean_type_name(typeid(T).name()));
+		}
+
+		ProfileScope scope(handler_profile_scope);
+		react_to_event(signal);
+	}
 };
 
 template<int T>
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+// a width x height array on the heap, row-major like the console and the fov map.
+// grid[x][y] still reads and writes a cell; loops over y then x walk memory in order.
+template<typename T>
+struct Grid
+{
+    struct Column
+    {
+        T* cells;
+        int width;
+
+        T& operator[](int y) { return cells[(size_t)y * width]; }
+    };
+
+    struct ConstColumn
+    {
+        const T* cells;
+        int width;
+
+        const T& operator[](int y) const { return cells[(size_t)y * width]; }
+    };
+
+    Grid() {}
+
+    Grid(int width, int height, const T& value = T{})
+    {
+        resize(width, height, value);
+    }
+
+    void resize(int width, int height, const T& value = T{})
+    {
+        this->width = width;
+        this->height = height;
+        cells.assign((size_t)width * height, value);
+    }
+
+    void fill(const T& value)
+    {
+        std::fill(cells.begin(), cells.end(), value);
+    }
+
+    int get_width() const { return width; }
+    int get_height() const { return height; }
+
+    bool in_bounds(int x, int y) const
+    {
+        return x >= 0 && y >= 0 && x < width && y < height;
+    }
+
+    int index(int x, int y) const
+    {
+        return y * width + x;
+    }
+
+    // the column at x; index it again with y
+    Column operator[](int x)
+    {
+        return Column{ cells.data() + x, width };
+    }
+
+    ConstColumn operator[](int x) const
+    {
+        return ConstColumn{ cells.data() + x, width };
+    }
+
+    T* row(int y) { return cells.data() + (size_t)y * width; }
+    const T* row(int y) const { return cells.data() + (size_t)y * width; }
+
+    T* data() { return cells.data(); }
+    const T* data() const { return cells.data(); }
+
+private:
+    int width = 0;
+    int height = 0;
+    std::vector<T> cells;
+};
@@ -39,11 +39,11 @@ bool HUDSystem::item_box(int index, Entity item, int x, int y)
 
 	if (item != entt::null)
 	{
-		if (!AccessWorld_QueryComponent<Item>::has_component(item)) return false;
-		if (!AccessWorld_QueryComponent<Symbol>::has_component(item)) return false;
+		if (!AccessWorld_QueryComponent<const Item>::has_component(item)) return false;
+		if (!AccessWorld_QueryComponent<const Symbol>::has_component(item)) return false;
 
-		auto name = AccessWorld_QueryComponent<Item>::get_component(item).name;
-		auto sym = AccessWorld_QueryComponent<Symbol>::get_component(item).sym;
+		auto name = AccessWorld_QueryComponent<const Item>::get_component(item).name;
+		auto sym = AccessWorld_QueryComponent<const Symbol>::get_component(item).sym;
 
 		str({ x + HUD_INVENTORY_BOX_MID_AT, SCREEN_HEIGHT - 4 - y - (int)selected }, sym, color);
 		str({ x + HUD_INVENTORY_BOX_MID_AT - 1, SCREEN_HEIGHT - 6 - y - (int)selected }, std::string("[") + std::to_string(index + 1) + "]", color);
@@ -60,7 +60,7 @@ bool HUDSystem::item_box(int index, Entity item, int x, int y)
 
 void HUDSystem::activate()
 {
-	const auto& calendar = AccessWorld_UseUnique<Calendar>::access_unique();
+	const auto& calendar = AccessWorld_UseUnique<const Calendar>::access_unique();
 
 	std::stringstream str;	
 
@@ -82,7 +82,7 @@ void HUDSystem::activate()
 	auto& game_context = AccessWorld_UseUnique<GameContext>::access_unique();
 	bool skip_this_frame = false;
 
-	auto all_players = AccessWorld_QueryAllEntitiesWith<Player, Inventory>::query();
+	auto all_players = AccessWorld_QueryAllEntitiesWith<const Player, Inventory>::query();
 	for (auto&& [ e, inv ] : all_players.each())
 	{
 		for (int i = 0; i < INVENTORY_SIZE; i++)
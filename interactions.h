@@ -4,10 +4,10 @@
 
 std::vector<Entity> tell_buddy_about_event(PeopleMapping& mapping, Entity who, Entity what_event, int time, int event_id, int max_count = 100)
 {
-	TCODRandom* rng = TCODRandom::getInstance();
+	TCODRandom* rng = get_random().stream(RandomStream::Plot);
 
 	auto all_visiting = mapping.get_all_visiting_with(who);
-	shuffle(all_visiting);
+	shuffle(all_visiting, rng);
 
 	std::vector<Entity> buddies_told;
 
@@ -46,10 +46,10 @@ std::vector<Entity> tell_buddy_about_event(PeopleMapping& mapping, Entity who, E
 
 std::vector<Entity> tell_work_buddy_about_event(PeopleMapping& mapping, Entity who, Entity what_event, int time, int event_id, int max_count = 100)
 {
-	TCODRandom* rng = TCODRandom::getInstance();
+	TCODRandom* rng = get_random().stream(RandomStream::Plot);
 
 	auto all_workers = mapping.get_all_working_with(who);
-	shuffle(all_workers);
+	shuffle(all_workers, rng);
 
 	auto talk_event = mapping.graph->create_node();
 	mapping.graph->label_node(talk_event, "TALK AT WORK");
@@ -95,7 +95,7 @@ void planned_murder(PeopleMapping& mapping, int event_id, Entity killer)
 
 void murder_debt_scare(PeopleMapping& mapping, int event_id, Entity victim = entt::null, bool is_murder = true)
 {
-	TCODRandom* rng = TCODRandom::getInstance();
+	TCODRandom* rng = get_random().stream(RandomStream::Plot);
 
 	// some past debt
 	auto past_debt_event = mapping.create_event("PAST DEBT", -100, event_id);
@@ -103,7 +103,7 @@ void murder_debt_scare(PeopleMapping& mapping, int event_id, Entity victim = ent
 	auto active_debt_time = rng->getInt(-30, -7);
 	auto active_debt = mapping.create_event("DEBT", active_debt_time, event_id);
 	
-	auto people = mapping.get_all_people_shuffled();
+	auto people = mapping.get_all_people_shuffled(rng);
 	auto old_debtee = people.back();
 	people.pop_back();
 
@@ -154,9 +154,9 @@ void murder_debt_scare(PeopleMapping& mapping, int event_id, Entity victim = ent
 
 void murder_old_grievance_revenge(PeopleMapping& mapping, int event_id, Entity victim = entt::null, bool is_murder = true)
 {
-	TCODRandom* rng = TCODRandom::getInstance();
+	TCODRandom* rng = get_random().stream(RandomStream::Plot);
 
-	auto people = mapping.get_all_people_shuffled();
+	auto people = mapping.get_all_people_shuffled(rng);
 	Entity killer;
 	if (mapping.killer != entt::null && rng->getInt(0, 100) > 65)
 	{
@@ -200,7 +200,7 @@ void murder_old_grievance_revenge(PeopleMapping& mapping, int event_id, Entity v
 	auto recent_violent_time = rng->getInt(-14, -7);
 	auto recent_violent_event = mapping.create_event("SCUFFLE", recent_violent_time, event_id);
 
-	auto places = mapping.get_all_places_shuffled();
+	auto places = mapping.get_all_places_shuffled(rng);
 	auto place = places.back(); places.pop_back();
 	
 	mapping.connect(recent_violent_event, place, "NEAR", event_id);
@@ -210,7 +210,7 @@ void murder_old_grievance_revenge(PeopleMapping& mapping, int event_id, Entity v
 
 	if (all_similar_visit.size() > 0)
 	{
-		shuffle(all_similar_visit);
+		shuffle(all_similar_visit, rng);
 		auto v = all_similar_visit.back(); all_similar_visit.pop_back();
 
 		almost_victim = std::get<0>(v);
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "common.h"
+
+// union-find over dense ids; the older (smaller) id always stays the root
+struct DisjointSets
+{
+    void reserve(int count)
+    {
+        parent.reserve(count);
+    }
+
+    void reset(int count = 0)
+    {
+        parent.resize(count);
+        for (int i = 0; i < count; i++) parent[i] = i;
+    }
+
+    int add()
+    {
+        parent.push_back((int)parent.size());
+        return (int)parent.size() - 1;
+    }
+
+    int size() const
+    {
+        return (int)parent.size();
+    }
+
+    int find(int id)
+    {
+        while (parent[id] != id)
+        {
+            parent[id] = parent[parent[id]];
+            id = parent[id];
+        }
+        return id;
+    }
+
+    // false if both were already in the same set
+    bool unite(int a, int b)
+    {
+        a = find(a);
+        b = find(b);
+        if (a == b) return false;
+
+        if (a < b)
+            parent[b] = a;
+        else
+            parent[a] = b;
+        return true;
+    }
+
+private:
+    std::vector<int> parent;
+};
+
+// a component's tiles are a run of the labeller's shared tile buffer, in row order
+struct LabelledComponent
+{
+    int size = 0;
+    int min_x, min_y, max_x, max_y;
+    const WorldPosition* tiles = nullptr;
+
+    const WorldPosition* begin() const { return tiles; }
+    const WorldPosition* end() const { return tiles + size; }
+};
+
+// two-pass union-find connected-component labeller. buffers are sized for the worst case of
+// the map, so labelling the same map size again allocates nothing. cells are visited row by
+// row (the layout of the level's grids), and components are numbered in that order too.
+struct ComponentLabeller
+{
+    static constexpr int NONE = -1;
+
+    template<typename Open>
+    void label(int width, int height, Open&& open, bool diagonal = true)
+    {
+        this->width = width;
+        this->height = height;
+
+        // with diagonals no two components share a 2x2 block, without them a checkerboard fits
+        // one per other cell; the per-component and per-label buffers are reserved to that
+        const int most = diagonal ? ((width + 1) / 2) * ((height + 1) / 2) : (width * height + 1) / 2;
+        labels.assign(width * height, NONE);
+        tiles.resize(width * height);
+        components.reserve(most);
+        starts.reserve(most);
+        remap.reserve(most);
+        sets.reserve(most);
+        sets.reset();
+
+        // first pass: provisional labels from the already-visited neighbours, equivalences into the forest
+        for (int y = 0; y < height; y++)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                if (!open(x, y)) continue;
+
+                int current = NONE;
+                const auto join = [&](int nx, int ny) {
+                    if (nx < 0 || ny < 0 || nx >= width) return;
+
+                    const int neighbour = labels[ny * width + nx];
+                    if (neighbour == NONE) return;
+
+                    if (current == NONE)
+                        current = sets.find(neighbour);
+                    else
+                        sets.unite(current, neighbour);
+                };
+
+                join(x - 1, y);
+                join(x, y - 1);
+                if (diagonal)
+                {
+                    join(x - 1, y - 1);
+                    join(x + 1, y - 1);
+                }
+
+                if (current == NONE)
+                {
+                    current = sets.add();
+                }
+
+                labels[y * width + x] = current;
+            }
+        }
+
+        // second pass: roots become dense component ids, in order of each component's first cell
+        remap.assign(sets.size(), NONE);
+        components.clear();
+        count = 0;
+
+        for (int y = 0; y < height; y++)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                auto& cell = labels[y * width + x];
+                if (cell == NONE) continue;
+
+                const int root = sets.find(cell);
+                if (remap[root] == NONE)
+                {
+                    remap[root] = count++;
+
+                    LabelledComponent fresh;
+                    fresh.min_x = fresh.max_x = x;
+                    fresh.min_y = fresh.max_y = y;
+                    components.push_back(fresh);
+                }
+
+                cell = remap[root];
+
+                auto& component = components[cell];
+                component.size++;
+                component.min_x = std::min(component.min_x, x);
+                component.max_x = std::max(component.max_x, x);
+                component.min_y = std::min(component.min_y, y);
+                component.max_y = std::max(component.max_y, y);
+            }
+        }
+
+        // third pass: each component gets its run of the tile buffer, filled in row order
+        starts.resize(count);
+        int first = 0;
+        for (int id = 0; id < count; id++)
+        {
+            starts[id] = first;
+            components[id].tiles = tiles.data() + first;
+            first += components[id].size;
+        }
+
+        for (int y = 0; y < height; y++)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                const int cell = labels[y * width + x];
+                if (cell != NONE) tiles[starts[cell]++] = WorldPosition{ x, y };
+            }
+        }
+    }
+
+    int get_count() const
+    {
+        return count;
+    }
+
+    const LabelledComponent& get_component(int id) const
+    {
+        return components[id];
+    }
+
+    // component id of a cell, or NONE if it was closed
+    int label_at(int x, int y) const
+    {
+        return labels[y * width + x];
+    }
+
+    bool connected(int x1, int y1, int x2, int y2) const
+    {
+        const int a = label_at(x1, y1);
+        return a != NONE && a == label_at(x2, y2);
+    }
+
+private:
+    int width = 0;
+    int height = 0;
+    int count = 0;
+
+    std::vector<int> labels;
+    std::vector<int> remap;
+    std::vector<int> starts;
+    std::vector<WorldPosition> tiles;
+    std::vector<LabelledComponent> components;
+    DisjointSets sets;
+};
@@ -2,57 +2,110 @@
 
 #include "config.h"
 #include "common.h"
-
+#include "corridors.h"
+#include "palette.h"
+#include "snapshot.h"
+#include "spanning.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
 #include <unordered_map>
 #include <yaml-cpp/yaml.h>
 
+int next_residency_version()
+{
+    // shared by every level, so a level swapped in never repeats the version of the one before it
+    static std::atomic<int> versions{ 0 };
+    return ++versions;
+}
+
+void Level::resize(int width, int height)
+{
+    this->width = width;
+    this->height = height;
+
+    scratch.digability.resize(width, height, 0.0f);
+    scratch.rooms.resize(width, height, NO_ROOM);
+    terrain.resize(width, height, Tile{});
+
+    scratch.flood_fill_visited.assign(width * height, false);
+    scratch.flood_fill_candidate.assign(width * height, false);
+    scratch.bombs.assign(width * height, false);
+
+    room_limit = std::max(ROOM_COUNT, (int)(ROOM_COUNT * area_scale()));
+    tiles_in_room.assign(room_limit, 0);
+
+    // emptied rather than replaced, so each room keeps its capacity for the next level
+    tiles.resize(room_limit);
+    for (auto& room : tiles) room.clear();
+
+    // lists that can't hold more than every tile (or, for regions, their disc) are reserved to
+    // that once per size, so regenerating never grows them
+    const int area = width * height;
+    walkable.reserve(area);
+    scratch.flood_fill_queue.reserve(area);
+    scratch.exploded_bombs.reserve(area);
+    scratch.corridor_points.reserve(area);
+    scratch.corridor_cells.reserve(area);
+    for (auto& region : region_tiles) region.reserve((2 * REGION_RADIUS_MAX + 1) * (2 * REGION_RADIUS_MAX + 1));
+
+    chunk_keep.assign(terrain.get_chunk_count(), true);
+    residency_version = next_residency_version();
+}
+
 void Level::init()
 {
     walkable.clear();
 
-    exploded_bombs.clear();
+    scratch.exploded_bombs.clear();
 
-    const auto& colors = AccessWorld_UseUnique<Colors>::access_unique();
-    TCODRandom* rng = TCODRandom::getInstance();
+    SplitMixRandom* rng = &terrain_rng;
+
+    // chunked tiles start out as the fill value, so only the cells that get dug cost memory
+    Tile rock;
+    rock.hue = colors.visible_hue;
+    rock.sat = colors.visible_sat;
+    rock.val = 0.75f;
+    terrain.fill(rock);
+    scratch.rooms.fill(NO_ROOM);
 
-    for (int i = 0; i < MAP_WIDTH; i++)
+    for (int j = 0; j < height; j++)
     {
-        for (int j = 0; j < MAP_HEIGHT; j++)
+        float* row = scratch.digability.row(j);
+        for (int i = 0; i < width; i++)
         {
-            dig[i][j] = ' ';
-            rooms[i][j] = ' ';
-            hues[i][j] = colors.visible_hue;
-            sats[i][j] = colors.visible_sat;
-            vals[i][j] = 0.75f;
-            digability[i][j] = rng->getFloat(0.0f, 1.0f, 0.5f);
+            row[i] = rng->getFloat(0.0f, 1.0f, 0.5f);
         }
     }
 }
 
 void Level::gradient()
 {
-    TCODRandom* rng = TCODRandom::getInstance();
+    SplitMixRandom* rng = &terrain_rng;
+
+    // bigger maps get proportionally more drops, with the decay stretched to match
+    const float scale = area_scale();
+    const float f_decay = std::pow(0.9991f, 1.0f / scale);
+    const float radius_decay = std::pow(0.995f, 1.0f / scale);
+    const int drops = (int)(450 * scale);
+
+    auto& drop = scratch.stamp;
+    drop.clip(0, 0, width, height);
 
     float f = 1.0f;
     float radius = 10.0f;
-    for (int i = 0; i < 450; i++)
+    for (int i = 0; i < drops; i++)
     {
-        f *= 0.9991f;
-        int x = rng->getInt(5, MAP_WIDTH - 5);
-        int y = rng->getInt(5, MAP_HEIGHT - 5);
+        f *= f_decay;
+        int x = rng->getInt(5, width - 5);
+        int y = rng->getInt(5, height - 5);
 
-        for (int i = -(int)radius; i < (int)radius; i++)
-        {
-            for (int j = -(int)radius; j < (int)radius; j++)
-            {
-                if (x + i < 0 || x + i > MAP_WIDTH - 1) continue;
-                if (y + j < 0 || y + j > MAP_HEIGHT - 1) continue;
-
-                digability[x + i][y + j] *= f;
-            }
-        }
+        const int r = (int)radius;
+        stamp::multiply(scratch.digability, drop.rect(x - r, y - r, x + r, y + r), f);
 
-        radius *= 0.995f;
+        radius *= radius_decay;
         if (radius < 1.0f)
         {
             break;
@@ -62,262 +115,318 @@ void Level::gradient()
 
 void Level::flood_fill(int bomb_count)
 {
-    TCODRandom* rng = TCODRandom::getInstance();
+    SplitMixRandom* rng = &terrain_rng;
 
-    bombs.reset();
+    std::fill(scratch.bombs.begin(), scratch.bombs.end(), false);
     for (int i = 0; i < bomb_count; i++)
     {
-        int8_t x = rng->getInt(5, MAP_WIDTH - 5);
-        int8_t y = rng->getInt(5, MAP_HEIGHT - 5);
-        bombs.set(TO_XY(x, y));
+        int x = rng->getInt(5, width - 5);
+        int y = rng->getInt(5, height - 5);
+        scratch.bombs[index(x, y)] = true;
     }
 
-    flood_fill_candidate.reset();
-    flood_fill_visited.reset();
+    // blasts stop short of the last row and column, like the fill itself
+    scratch.stamp.clip(0, 0, width - 1, height - 1);
+
+    std::fill(scratch.flood_fill_candidate.begin(), scratch.flood_fill_candidate.end(), false);
+    std::fill(scratch.flood_fill_visited.begin(), scratch.flood_fill_visited.end(), false);
 
-    while (!flood_fill_freelist.empty())
+    // a plain vector walked from the front; it only empties once the fill is done
+    auto& queue = scratch.flood_fill_queue;
+    for (size_t head = 0; head < queue.size(); head++)
     {
-        auto next = flood_fill_freelist.front();
-        flood_fill_freelist.pop_front();
+        const auto next = queue[head];
 
-        dig[next.x][next.y] = '.';
-        digability[next.x][next.y] = 0.0f;
-        flood_fill_visited.set(TO_XY(next.x, next.y));
+        tile(next.x, next.y).dig = '.';
+        scratch.digability[next.x][next.y] = 0.0f;
+        scratch.flood_fill_visited[index(next.x, next.y)] = true;
 
-        for (int8_t i = -1; i < 2; i++)
+        for (int i = -1; i < 2; i++)
         {
             if (next.x + i < 0) continue;
-            if (next.x + i >= MAP_WIDTH - 1) continue;
+            if (next.x + i >= width - 1) continue;
 
-            for (int8_t j = -1; j < 2; j++)
+            for (int j = -1; j < 2; j++)
             {
                 if (next.y + j < 0) continue;
-                if (next.y + j >= MAP_HEIGHT - 1) continue;
+                if (next.y + j >= height - 1) continue;
 
                 if (i == 0 && j == 0) continue;
 
-                int8_t x = (int8_t)(next.x + i);
-                int8_t y = (int8_t)(next.y + j);
+                int16_t x = (int16_t)(next.x + i);
+                int16_t y = (int16_t)(next.y + j);
 
-                int ixy = TO_XY(x, y);
+                int ixy = index(x, y);
 
-                if (flood_fill_candidate.test(ixy)) continue;
+                if (scratch.flood_fill_candidate[ixy]) continue;
 
-                if (!flood_fill_visited.test(ixy))
+                if (!scratch.flood_fill_visited[ixy])
                 {
-                    if (bombs.test(ixy))
+                    if (scratch.bombs[ixy])
                     {
-                        bombs.reset(ixy);
-                        exploded_bombs.push_back(XY{ x, y });
+                        scratch.bombs[ixy] = false;
+                        scratch.exploded_bombs.push_back(XY{ x, y });
 
-                        int impact = rng->getInt(2, 5);
-                        for (int8_t k = -impact; k < impact + 1; k++)
-                        {
-                            if (x + k < 0) continue;
-                            if (x + k >= MAP_WIDTH - 1) continue;
+                        // one roll per cell says whether it caves in, another how soft it gets
+                        auto& blast = scratch.stamp.disc(x, y, rng->getInt(2, 5));
+                        stamp::random(rng, blast, scratch.stamp_rolls, 0.0f, 1.0f);
+                        stamp::random(rng, blast, scratch.stamp_values, 0.8f, 1.0f);
+                        stamp::set_where(scratch.digability, blast, scratch.stamp_values.data(), scratch.stamp_rolls.data(), 0.15f);
 
-                            for (int8_t l = -impact; l < impact + 1; l++)
+                        int k = 0;
+                        for (const auto& span : blast.spans)
+                        {
+                            for (int cx = span.x0; cx < span.x1; cx++, k++)
                             {
-                                if (y + l < 0) continue;
-                                if (y + l >= MAP_HEIGHT - 1) continue;
-
-                                int dist = k * k + l * l;
-                                if (dist <= impact * impact)
-                                {
-                                    if (rng->getFloat(0.0f, 1.0f) < 0.15f) continue;
-
-                                    dig[x + k][y + l] = '*';
-                                    digability[x + k][y + l] = rng->getFloat(0.8f, 1.0f);
-                                }
+                                if (scratch.stamp_rolls[k] >= 0.15f) tile(cx, span.y).dig = '*';
                             }
                         }
                     }
-                    else if (digability[x][y] < 0.2f)
+                    else if (scratch.digability[x][y] < 0.2f)
                     {
-                        flood_fill_freelist.push_back(XY{ x, y });
-                        flood_fill_candidate.set(ixy);
+                        queue.push_back(XY{ x, y });
+                        scratch.flood_fill_candidate[ixy] = true;
                     }
                 }
             }
         }
     }
+
+    queue.clear();
 }
 
 void Level::minesweep()
 {
-    TCODRandom* rng = TCODRandom::getInstance();
+    SplitMixRandom* rng = &terrain_rng;
 
-    int dig_attempts = 20;
+    const int dig_attempts = (int)(20 * area_scale());
     int bomb_count = 10;
     for (int i = 0; i < dig_attempts; i++)
     {
-        auto x = (int8_t)rng->getInt(5, MAP_WIDTH - 5);
-        auto y = (int8_t)rng->getInt(5, MAP_HEIGHT - 5);
-        flood_fill_freelist.push_back(XY{ x, y });
-        flood_fill(bomb_count);
+        auto x = (int16_t)rng->getInt(5, width - 5);
+        auto y = (int16_t)rng->getInt(5, height - 5);
+        scratch.flood_fill_queue.push_back(XY{ x, y });
+        flood_fill(std::max(bomb_count, 0));
         if (i % 3 == 0) bomb_count--;
     }
 }
 
-void Level::connect()
+void Level::carve_corridors()
 {
-    int index = 0;
-    std::vector<graphs::NodeEntity> nodes;
+    const auto& points = scratch.corridor_points;
+    const auto& mst = scratch.spanning.build(points);
 
-    for (auto xy : exploded_bombs)
+    scratch.corridor_cells.clear();
+    if ((int)points.size() >= CORRIDOR_SWEEP_MIN_POINTS)
     {
-        auto node = dig_plan.create_node();
-        dig_plan.tag_node<XY>(node, xy.x, xy.y);
-        nodes.push_back(node);
+        scratch.carver.find_tree_paths(points, mst, scratch.corridor_cells);
     }
-
-    for (auto node1 : nodes)
+    else
     {
-        for (auto node2 : nodes)
+        for (const auto& edge : mst)
         {
-            if (node1 == node2) continue;
+            scratch.carver.find_path(points[edge.a], points[edge.b], scratch.corridor_cells);
+        }
+    }
 
-            auto arrow = dig_plan.create_arrows(node1, node2);
-            auto xy1 = dig_plan.get_tag<XY>(node1);
-            auto xy2 = dig_plan.get_tag<XY>(node2);
-            dig_plan.weigh_edge(arrow, xy1.distance(xy2));
+    for (const auto& cell : scratch.corridor_cells)
+    {
+        if (tile(cell.x, cell.y).dig != '.')
+        {
+            scratch.digability[cell.x][cell.y] = 0.0f;
+            tile(cell.x, cell.y).dig = '.';
         }
     }
+}
 
-    auto mst = dig_plan.get_minimum_spanning_tree();
+void Level::connect()
+{
+    auto& points = scratch.corridor_points;
+    points.clear();
+    for (auto xy : scratch.exploded_bombs)
+    {
+        points.push_back(WorldPosition{ xy.x, xy.y });
+    }
 
-    TCODRandom* rng = TCODRandom::getInstance();
-    map = new TCODMap(MAP_WIDTH, MAP_HEIGHT);
-    for (int i = 0; i < MAP_WIDTH; i++)
+    // straight steps only, around a scatter of random obstacles
+    SplitMixRandom* rng = &terrain_rng;
+    scratch.carver.reset(width, height);
+    scratch.carver.diagonal = false;
+    for (int j = 0; j < height; j++)
     {
-        for (int j = 0; j < MAP_HEIGHT; j++)
+        for (int i = 0; i < width; i++)
         {
             bool ok = rng->getFloat(0.0f, 1.0f) > 0.13f;
-            map->setProperties(i, j, ok, ok);
+            scratch.carver.block(i, j, !ok);
         }
     }
 
-    auto d = TCOD_dijkstra_new_using_function(MAP_WIDTH, MAP_HEIGHT, [](int xFrom, int yFrom, int xTo, int yTo, void* user_data) -> float {
-        Level* level = (Level*)user_data;
-        if (level->map->isWalkable(xTo, yTo))
-        {
-            return (float)(std::abs(xFrom - xTo) + std::abs(yFrom - yTo));
-        }
-        else
+    carve_corridors();
+}
+
+template<typename Board>
+static void run_cellular_automata(Level& level, Board& open, const CellularRule& rule, int passes)
+{
+    for (int j = 0; j < level.height; j++)
+    {
+        for (int i = 0; i < level.width; i++)
         {
-            return 0.0f;
+            if (level.peek(i, j).dig != ' ') open.set(i, j);
         }
-        }, this, 0.0f);
+    }
 
-    for (auto edge : mst)
+    for (int pass = 0; pass < passes; pass++)
     {
-        auto source = dig_plan.get_tag<XY>(dig_plan.get_source(edge));
-        auto target = dig_plan.get_tag<XY>(dig_plan.get_target(edge));
+        open.step(rule);
+    }
 
-        TCOD_dijkstra_compute(d, source.x, source.y);
-        if (TCOD_dijkstra_path_set(d, target.x, target.y))
+    // only cells whose state flipped are written back, so dug symbols survive
+    for (int j = 0; j < level.height; j++)
+    {
+        for (int i = 0; i < level.width; i++)
         {
-            int x, y;
-            while (TCOD_dijkstra_path_walk(d, &x, &y))
-            {
-                if (dig[x][y] != '.')
-                {
-                    digability[x][y] = 0.0f;
-                    dig[x][y] = '.';
-                }
-            }
+            const bool was_open = level.peek(i, j).dig != ' ';
+            if (was_open == open.get(i, j)) continue;
+
+            level.tile(i, j).dig = was_open ? ' ' : '.';
         }
     }
+}
 
-    TCOD_dijkstra_delete(d);
+void Level::cellular_automata(const CellularRule& rule, int passes)
+{
+    // the default size keeps its compile-time board; anything else is sized at runtime
+    if (width == MAP_WIDTH && height == MAP_HEIGHT)
+    {
+        Bitboard<MAP_WIDTH, MAP_HEIGHT> open;
+        run_cellular_automata(*this, open, rule, passes);
+    }
+    else
+    {
+        auto& open = scratch.cellular_board;
+        open.resize(width, height);
+        run_cellular_automata(*this, open, rule, passes);
+    }
 }
 
-void Level::cellular_automata()
+void Level::room_counting()
 {
-    // ovo ce da prodje ceo ekran
-    for (int i = 0; i < MAP_WIDTH; i++)
+    for (int i = 0; i < room_limit; i++)
     {
-        for (int j = 0; j < MAP_HEIGHT; j++)
-        {
-            if (dig[i][j] == ' ') continue;
+        tiles_in_room[i] = 0;
+        tiles[i].clear();
+    }
 
-            int count_neighbors = 0;
-            // ovo ce da prodje sve komsije
-            for (int k = -1; k < 2; k++)
-            {
-                for (int l = -1; l < 2; l++)
-                {
-                    if (k == 0 && l == 0) continue;
+    scratch.rooms.fill(NO_ROOM);
+    scratch.room_labeller.label(width, height, [&](int x, int y) { return peek(x, y).dig != ' '; });
 
-                    int x = i + k;
-                    int y = j + l;
+    int room = 0;
+    for (int n = 0; n < scratch.room_labeller.get_count(); n++)
+    {
+        const auto& component = scratch.room_labeller.get_component(n);
 
-                    if (x < 0) continue;
-                    if (y < 0) continue;
-                    if (x >= MAP_WIDTH) continue;
-                    if (y >= MAP_HEIGHT) continue;
+        // small rooms are filled in, and so is anything past room_limit, which has no slot to live in
+        const bool keep = component.size >= MIN_TILES_PER_ROOM && room < room_limit;
 
-                    if (dig[x][y] != ' ')
-                    {
-                        count_neighbors++;
-                    }
-                }
+        for (const auto& cell : component)
+        {
+            if (keep)
+            {
+                scratch.rooms.row(cell.y)[cell.x] = room;
             }
-
-            if (count_neighbors == 0)
+            else
             {
-                dig[i][j] = ' ';
+                tile(cell.x, cell.y).dig = ' ';
+                scratch.rooms.row(cell.y)[cell.x] = NO_ROOM;
             }
         }
+
+        if (keep)
+        {
+            tiles[room].assign(component.begin(), component.end());
+            tiles_in_room[room] = component.size;
+            room++;
+        }
     }
 }
 
-void Level::flood_fill_rooms(int start_x, int start_y, char current_room)
+void Level::force_connect()
 {
-    TCODRandom* rng = TCODRandom::getInstance();
+    auto& points = scratch.corridor_points;
+    points.clear();
+    for (int i = 0; i < room_limit; i++)
+    {
+        if (tiles_in_room[i] >= MIN_TILES_PER_ROOM)
+        {
+            points.push_back(tiles[i][tiles_in_room[i] / 2]);
+        }
+    }
 
-    flood_fill_freelist.clear();
-    flood_fill_freelist.push_back(XY{ (int8_t)start_x, (int8_t)start_y });
+    if (points.size() <= 1) return;
 
-    flood_fill_candidate.reset();
-    flood_fill_visited.reset();
+    // open ground everywhere, diagonals allowed
+    scratch.carver.reset(width, height);
+    scratch.carver.diagonal = true;
+    scratch.carver.diagonal_cost = 1.41f;
 
-    while (!flood_fill_freelist.empty())
+    carve_corridors();
+}
+
+void Level::flood_fill_regions()
+{
+    SplitMixRandom* rng = &region_rng;
+
+    region_centers.clear();
+    for (int i = 0; i < REGION_COUNT; i++)
     {
-        auto next = flood_fill_freelist.front();
-        flood_fill_freelist.pop_front();
+        region_tiles[i].clear();
+    }
 
-        rooms[next.x][next.y] = current_room;
-        int index = (int)(current_room - '1');
-        tiles[index].push_back({ (int)next.x, (int)next.y });
-        tiles_in_room[index]++;
-        flood_fill_visited.set(TO_XY(next.x, next.y));
+    if (walkable.empty()) return;
 
-        for (int8_t i = -1; i < 2; i++)
-        {
-            if (next.x + i < 0) continue;
-            if (next.x + i >= MAP_WIDTH - 1) continue;
+    // widest spacing that still fits every region; at spacing 1 any distinct tiles do
+    for (int spacing = REGION_SPACING; ; spacing = std::max(1, spacing - 2))
+    {
+        scratch.sampler.sample(walkable, spacing, rng, region_centers, REGION_COUNT);
+        if (region_centers.size() == REGION_COUNT || spacing == 1) break;
+    }
 
-            for (int8_t j = -1; j < 2; j++)
-            {
-                if (next.y + j < 0) continue;
-                if (next.y + j >= MAP_HEIGHT - 1) continue;
+    // fewer walkable tiles than regions: regions share centres
+    for (int i = (int)region_centers.size(); i < REGION_COUNT; i++)
+    {
+        region_centers.push_back(region_centers[i % region_centers.size()]);
+    }
 
-                if (i == 0 && j == 0) continue;
+    for (int i = 0; i < REGION_COUNT; i++)
+    {
+        const WorldPosition xy = region_centers[i];
 
-                int8_t x = (int8_t)(next.x + i);
-                int8_t y = (int8_t)(next.y + j);
+        // spacing keeps centres apart, so each paints its own disc; where the map is too small to
+        // keep them apart, a later region paints over an earlier one (link_tiles then drops the
+        // tile from the earlier region's list)
+        int x = xy.x;
+        int y = xy.y;
 
-                int ixy = TO_XY(x, y);
+        int impact = rng->getInt(5, REGION_RADIUS_MAX);
 
-                if (flood_fill_candidate.test(ixy)) continue;
+        // zumance
+        for (int k = -impact; k < impact + 1; k++)
+        {
+            if (x + k < 0) continue;
+            if (x + k >= width - 1) continue;
+
+            for (int l = -impact; l < impact + 1; l++)
+            {
+                if (y + l < 0) continue;
+                if (y + l >= height - 1) continue;
 
-                if (!flood_fill_visited.test(ixy))
+                int dist = k * k + l * l;
+                if (dist <= impact * impact)
                 {
-                    if (dig[x][y] != ' ' && rooms[x][y] == ' ')
+                    if (tile(x + k, y + l).dig != ' ' && tile(x + k, y + l).dig != '0')
                     {
-                        flood_fill_freelist.push_back(XY{ x, y });
-                        flood_fill_candidate.set(ixy);
+                        tile(x + k, y + l).region = '1' + i;
+                        region_tiles[i].push_back({ x + k, y + l });
                     }
                 }
             }
@@ -325,256 +434,372 @@ void Level::flood_fill_rooms(int start_x, int start_y, char current_room)
     }
 }
 
-void Level::room_counting()
+void Level::update_map_visibility()
 {
-    tiles->clear();
-    for (int i = 0; i < ROOM_COUNT; i++)
-    {
-        tiles_in_room[i] = 0;
-    }
+    opacity.resize(width, height, 0);
 
-    for (int i = 0; i < MAP_WIDTH; i++)
+    // read through peek() so untouched chunks stay unallocated, in the terrain and here
+    for (int j = 0; j < height; j++)
     {
-        for (int j = 0; j < MAP_HEIGHT; j++)
+        for (int i = 0; i < width; i++)
         {
-            rooms[i][j] = ' ';
+            if (peek(i, j).dig != ' ') opacity.at(i, j) = OPEN_SIGHT | OPEN_WALK;
         }
     }
+}
+
+void Level::set_properties(int x, int y, bool transparent, bool walkable)
+{
+    const uint8_t flags = (transparent ? OPEN_SIGHT : 0) | (walkable ? OPEN_WALK : 0);
+    if (opacity.get(x, y) != flags) opacity.at(x, y) = flags;
+}
+
+bool Level::is_transparent(int x, int y) const
+{
+    return opacity.in_bounds(x, y) && (opacity.get(x, y) & OPEN_SIGHT) != 0;
+}
+
+bool Level::is_walkable(int x, int y) const
+{
+    return opacity.in_bounds(x, y) && (opacity.get(x, y) & OPEN_WALK) != 0;
+}
 
-    char current_room = '1';
-    for (int i = 0; i < MAP_WIDTH; i++)
+void Level::compute_fov(int x, int y, int radius)
+{
+    const int size = 2 * radius + 1;
+    if (!fov_map || fov_map->getWidth() < size)
     {
-        for (int j = 0; j < MAP_HEIGHT; j++)
-        {
-            if (dig[i][j] != ' ' && rooms[i][j] == ' ')
-            {
-                flood_fill_rooms(i, j, current_room++);
-                walkable.push_back({ i, j });
-            }
-        }
+        fov_map.reset(new TCODMap(size, size));
     }
 
-    for (int n = 0; n < ROOM_COUNT; n++)
+    // centred on the viewer; tiles past the level's edge are solid
+    const int window = fov_map->getWidth();
+    fov_x = x - window / 2;
+    fov_y = y - window / 2;
+
+    for (int j = 0; j < window; j++)
     {
-        if (tiles_in_room[n] < MIN_TILES_PER_ROOM)
+        for (int i = 0; i < window; i++)
         {
-            for (int i = 0; i < MAP_WIDTH; i++)
-            {
-                for (int j = 0; j < MAP_HEIGHT; j++)
-                {
-                    if (rooms[i][j] == (char)(n + '1'))
-                    {
-                        dig[i][j] = ' ';
-                        rooms[i][j] = ' ';
-                    }
-                }
-            }
-
-            tiles_in_room[n] = 0;
-            tiles[n].clear();
+            const auto flags = opacity.in_bounds(fov_x + i, fov_y + j) ? opacity.get(fov_x + i, fov_y + j) : 0;
+            fov_map->setProperties(i, j, (flags & OPEN_SIGHT) != 0, (flags & OPEN_WALK) != 0);
         }
     }
+
+    fov_map->computeFov(x - fov_x, y - fov_y, radius, true, FOV_RESTRICTIVE);
 }
 
-void Level::force_connect()
+bool Level::is_in_fov(int x, int y) const
+{
+    if (!fov_map) return false;
+
+    const int i = x - fov_x;
+    const int j = y - fov_y;
+    const int window = fov_map->getWidth();
+    return i >= 0 && j >= 0 && i < window && j < window && fov_map->isInFov(i, j);
+}
+
+void Level::link_tiles()
 {
-    int index = 0;
-    std::vector<graphs::NodeEntity> nodes;
+    links.resize(width, height, TileLinks{});
+    edits = LevelEdits{};
 
-    for (int i = 0; i < ROOM_COUNT; i++)
+    for (int i = 0; i < (int)walkable.size(); i++)
     {
-        if (tiles_in_room[i] >= MIN_TILES_PER_ROOM)
+        links.at(walkable[i].x, walkable[i].y).walkable = i;
+    }
+
+    for (int r = 0; r < (int)tiles.size(); r++)
+    {
+        for (int i = 0; i < (int)tiles[r].size(); i++)
         {
-            auto xy = tiles[i][tiles_in_room[i] / 2];
-            auto node = dig_plan.create_node();
-            dig_plan.tag_node<WorldPosition>(node, xy.x, xy.y);
-            nodes.push_back(node);
+            auto& link = links.at(tiles[r][i].x, tiles[r][i].y);
+            link.room = r;
+            link.room_slot = i;
         }
     }
 
-    if (nodes.size() <= 1) return;
-
-    for (auto node1 : nodes)
+    // a tile painted by two regions only stays in the list of the one it shows, so every
+    // listed tile has exactly one slot and a swap-remove never moves a tile it doesn't own
+    for (int r = 0; r < REGION_COUNT; r++)
     {
-        for (auto node2 : nodes)
-        {
-            if (node1 == node2) continue;
+        auto& list = region_tiles[r];
+        list.erase(std::remove_if(list.begin(), list.end(), [&](const WorldPosition& pos) {
+            return peek(pos.x, pos.y).region != '1' + r;
+        }), list.end());
 
-            auto arrow = dig_plan.create_arrows(node1, node2);
-            auto xy1 = dig_plan.get_tag<WorldPosition>(node1);
-            auto xy2 = dig_plan.get_tag<WorldPosition>(node2);
-            dig_plan.weigh_edge(arrow, xy1.distance(xy2));
+        for (int i = 0; i < (int)list.size(); i++)
+        {
+            links.at(list[i].x, list[i].y).region_slot = i;
         }
     }
+}
+
+void Level::unlink(std::vector<WorldPosition>& list, int slot, int32_t TileLinks::* field)
+{
+    if (slot < 0 || slot >= (int)list.size()) return;
 
-    auto mst = dig_plan.get_minimum_spanning_tree();
+    // the last entry fills the hole, and its tile learns its new slot
+    const auto last = list.back();
+    list[slot] = last;
+    list.pop_back();
 
-    TCODRandom* rng = TCODRandom::getInstance();
-    map = new TCODMap(MAP_WIDTH, MAP_HEIGHT);
-    for (int i = 0; i < MAP_WIDTH; i++)
+    if (slot < (int)list.size()) links.at(last.x, last.y).*field = slot;
+}
+
+int Level::free_room()
+{
+    for (int r = 0; r < (int)tiles.size(); r++)
     {
-        for (int j = 0; j < MAP_HEIGHT; j++)
-        {
-            map->setProperties(i, j, true, true);
-        }
+        if (tiles[r].empty()) return r;
     }
 
-    auto d = TCOD_dijkstra_new_using_function(MAP_WIDTH, MAP_HEIGHT, 
-        [](int xFrom, int yFrom, int xTo, int yTo, void* user_data) -> float {
-        
-            Level* level = (Level*)user_data;
-        if (level->map->isWalkable(xTo, yTo))
-        {
-            return (float)(std::abs(xFrom - xTo) + std::abs(yFrom - yTo));
-        }
-        else
+    tiles.emplace_back();
+    tiles_in_room.push_back(0);
+    room_limit = (int)tiles.size();
+    return room_limit - 1;
+}
+
+void Level::merge_room(int from, int into)
+{
+    for (const auto& pos : tiles[from])
+    {
+        auto& link = links.at(pos.x, pos.y);
+        link.room = into;
+        link.room_slot = (int)tiles[into].size();
+        tiles[into].push_back(pos);
+    }
+
+    tiles_in_room[into] += tiles_in_room[from];
+    tiles_in_room[from] = 0;
+    tiles[from].clear();
+}
+
+void Level::dig(int x, int y, char floor)
+{
+    if (!terrain.in_bounds(x, y) || peek(x, y).dig != ' ') return;
+
+    // joins the biggest room around it, taking the others along, and the first region it touches
+    int room = NO_ROOM;
+    char region = ' ';
+    for (int j = y - 1; j <= y + 1; j++)
+    {
+        for (int i = x - 1; i <= x + 1; i++)
         {
-            return 0.0f;
+            if (!terrain.in_bounds(i, j) || (i == x && j == y)) continue;
+
+            const auto next = links.get(i, j);
+            if (next.room != NO_ROOM && (room == NO_ROOM || tiles[next.room].size() > tiles[room].size())) room = next.room;
+            if (region == ' ' && next.region_slot >= 0) region = peek(i, j).region;
         }
-        }, this, 1.41f);
+    }
 
-    for (auto edge : mst)
+    if (room == NO_ROOM)
     {
-        auto source = dig_plan.get_tag<WorldPosition>(dig_plan.get_source(edge));
-        auto target = dig_plan.get_tag<WorldPosition>(dig_plan.get_target(edge));
-
-        TCOD_dijkstra_compute(d, source.x, source.y);
-        if (TCOD_dijkstra_path_set(d, target.x, target.y))
+        room = free_room();
+    }
+    else
+    {
+        for (int j = y - 1; j <= y + 1; j++)
         {
-            int x, y;
-            while (TCOD_dijkstra_path_walk(d, &x, &y))
+            for (int i = x - 1; i <= x + 1; i++)
             {
-                if (dig[x][y] != '.')
-                {
-                    digability[x][y] = 0.0f;
-                    dig[x][y] = '.';
-                }
+                if (!terrain.in_bounds(i, j)) continue;
+
+                const int other = links.get(i, j).room;
+                if (other != NO_ROOM && other != room) merge_room(other, room);
             }
         }
     }
 
-    TCOD_dijkstra_delete(d);
+    auto& cell = tile(x, y);
+    cell.dig = floor;
+    cell.region = region;
+
+    auto& link = links.at(x, y);
+    link.walkable = (int)walkable.size();
+    walkable.push_back({ x, y });
+
+    link.room = room;
+    link.room_slot = (int)tiles[room].size();
+    tiles[room].push_back({ x, y });
+    tiles_in_room[room]++;
+
+    if (region != ' ')
+    {
+        link.region_slot = (int)region_tiles[region - '1'].size();
+        region_tiles[region - '1'].push_back({ x, y });
+    }
+
+    set_properties(x, y, true, true);
+    edits.add(x, y);
 }
 
-void Level::flood_fill_regions()
+void Level::fill(int x, int y)
 {
-    TCODRandom* rng = TCODRandom::getInstance();
+    if (!terrain.in_bounds(x, y) || peek(x, y).dig == ' ') return;
 
-    int regions_left = REGION_COUNT;
-    int length = walkable.size() - 1;
+    const auto link = links.get(x, y);
+    const char region = peek(x, y).region;
 
-    for (int i = 0; i < REGION_COUNT; i++)
+    unlink(walkable, link.walkable, &TileLinks::walkable);
+
+    if (link.room != NO_ROOM)
     {
-        region_tiles[i].clear();
+        unlink(tiles[link.room], link.room_slot, &TileLinks::room_slot);
+        tiles_in_room[link.room]--;
     }
 
-    for (int i = 0; i < MAP_WIDTH; i++)
+    if (region != ' ')
+    {
+        unlink(region_tiles[region - '1'], link.region_slot, &TileLinks::region_slot);
+    }
+
+    auto& cell = tile(x, y);
+    cell.dig = ' ';
+    cell.region = ' ';
+    links.at(x, y) = TileLinks{};
+
+    set_properties(x, y, false, false);
+    edits.add(x, y);
+}
+
+void Level::dig_rect(int x0, int y0, int x1, int y1, char floor)
+{
+    for (int j = y0; j < y1; j++)
     {
-        for (int j = 0; j < MAP_HEIGHT; j++)
+        for (int i = x0; i < x1; i++)
         {
-            regions[i][j] = ' ';
+            dig(i, j, floor);
         }
     }
+}
 
-    for (int i = 0; i < regions_left; i++)
+void Level::fill_rect(int x0, int y0, int x1, int y1)
+{
+    for (int j = y0; j < y1; j++)
     {
-        WorldPosition xy{ 0, 0 };
-
-        float current_distance = 20;
-
-        int attempts = 0;
+        for (int i = x0; i < x1; i++)
+        {
+            fill(i, j);
+        }
+    }
+}
 
-        while (true) {
-            attempts++;
-            if (attempts % 10 == 0)
-            {
-                current_distance -= 2;
-                if (current_distance < 1) current_distance = 1;
-            }
+LevelEdits Level::take_edits()
+{
+    const auto taken = edits;
+    edits = LevelEdits{};
+    return taken;
+}
 
-            xy = walkable[rng->getInt(0, length)];
+bool Level::update_residency(const std::vector<WorldPosition>& active)
+{
+    const int chunks_x = terrain.get_chunks_x();
+    const int chunks_y = terrain.get_chunks_y();
+    next_keep.assign(terrain.get_chunk_count(), false);
 
-            if (regions[xy.x][xy.y] != ' ') continue;
+    for (const auto& pos : active)
+    {
+        const int from_x = std::max(0, (pos.x - CHUNK_KEEP_RADIUS) >> CHUNK_SHIFT);
+        const int to_x = std::min(chunks_x - 1, (pos.x + CHUNK_KEEP_RADIUS) >> CHUNK_SHIFT);
+        const int from_y = std::max(0, (pos.y - CHUNK_KEEP_RADIUS) >> CHUNK_SHIFT);
+        const int to_y = std::min(chunks_y - 1, (pos.y + CHUNK_KEEP_RADIUS) >> CHUNK_SHIFT);
 
-            bool okay = true;
-            for (auto center : region_centers)
+        for (int cy = from_y; cy <= to_y; cy++)
+        {
+            for (int cx = from_x; cx <= to_x; cx++)
             {
-                auto d = std::sqrt(center.distance(xy));
-                if (d < current_distance) okay = false;
+                next_keep[cy * chunks_x + cx] = true;
             }
-
-            if (okay)
-                break;
         }
+    }
 
-        region_centers.push_back(xy);
+    // everyone stayed within the same chunks: nothing to pack
+    if (next_keep == chunk_keep) return false;
 
-        if (regions[xy.x][xy.y] == ' ')
-        {
-            int x = xy.x;
-            int y = xy.y;
+    std::swap(chunk_keep, next_keep);
+    residency_version = next_residency_version();
 
-            int impact = rng->getInt(5, 7);
+    terrain.compress_except(chunk_keep);
+    links.compress_except(chunk_keep);
+    opacity.compress_except(chunk_keep);
+    return true;
+}
 
-            // zumance
-            for (int8_t k = -impact; k < impact + 1; k++)
-            {
-                if (x + k < 0) continue;
-                if (x + k >= MAP_WIDTH - 1) continue;
+size_t Level::memory_used() const
+{
+    return terrain.memory_used() + links.memory_used() + opacity.memory_used();
+}
 
-                for (int8_t l = -impact; l < impact + 1; l++)
-                {
-                    if (y + l < 0) continue;
-                    if (y + l >= MAP_HEIGHT - 1) continue;
+const char* get_level_stage_name(LevelStage stage)
+{
+    static const char* names[(int)LevelStage::COUNT]{
+        "init", "gradient", "minesweep", "cellular_automata", "room_counting",
+        "connect", "force_connect", "flood_fill_regions", "update_map_visibility",
+        "link_tiles",
+    };
 
-                    int dist = k * k + l * l;
-                    if (dist <= impact * impact)
-                    {
-                        if (dig[x + k][y + l] != ' ' && dig[x + k][y + l] != '0')
-                        {
-                            regions[x + k][y + l] = '1' + i;
-                            region_tiles[i].push_back({ x + k, y + l });
-                        }
-                    }
-                }
-            }
-        }
-    }
+    return names[(int)stage];
 }
 
-void Level::update_map_visibility()
+void Level::generate(uint64_t seed, int width, int height, LevelArena* arena, LevelStageObserver* observer)
 {
-    for (int i = 0; i < MAP_WIDTH; i++)
-    {
-        for (int j = 0; j < MAP_HEIGHT; j++)
+    static const int profile_scope = get_profiler().register_scope("Level::generate");
+    ProfileScope scope(profile_scope);
+
+    static int stage_scopes[(int)LevelStage::COUNT];
+    static std::once_flag registered;
+    std::call_once(registered, []() {
+        for (int i = 0; i < (int)LevelStage::COUNT; i++)
         {
-            memory[i][j] = ' ';
-            map->setProperties(i, j, dig[i][j] != ' ', dig[i][j] != ' ');            
+            stage_scopes[i] = get_profiler().register_scope(std::string("Level::") + get_level_stage_name((LevelStage)i));
         }
-    }
-}
+    });
 
-void Level::generate()
-{
-    init();
+    const auto run = [&](LevelStage stage, auto&& step) {
+        if (observer) observer->begin_stage(stage);
+        {
+            ProfileScope stage_scope(stage_scopes[(int)stage]);
+            step();
+        }
+        if (observer) observer->end_stage(stage);
+    };
+
+    if (arena) std::swap(scratch, *arena);
+
+    this->seed = seed;
+    reseed_stream(terrain_rng, seed, RandomStream::Level);
+    reseed_stream(region_rng, seed, RandomStream::Regions);
 
-    gradient();
-    minesweep();
-    cellular_automata();
+    run(LevelStage::Init, [&]() { resize(width, height); init(); });
 
-    room_counting();
-    connect();
-    force_connect();
+    run(LevelStage::Gradient, [&]() { gradient(); });
+    run(LevelStage::Minesweep, [&]() { minesweep(); });
+    run(LevelStage::CellularAutomata, [&]() { cellular_automata(); });
 
-    room_counting();
+    run(LevelStage::RoomCounting, [&]() { room_counting(); });
+    run(LevelStage::Connect, [&]() { connect(); });
+    run(LevelStage::ForceConnect, [&]() { force_connect(); });
+
+    run(LevelStage::RoomCounting, [&]() { room_counting(); });
     walkable = tiles[0];
 
-    flood_fill_regions();
-    update_map_visibility();
+    run(LevelStage::FloodFillRegions, [&]() { flood_fill_regions(); });
+    run(LevelStage::UpdateMapVisibility, [&]() { update_map_visibility(); });
+    run(LevelStage::LinkTiles, [&]() { link_tiles(); });
+
+    // the played level keeps no scratch: it goes back to the arena, or is freed
+    if (arena)
+        std::swap(scratch, *arena);
+    else
+        scratch = LevelArena();
 }
 
 void LevelCreationSystem::activate()
 {   
+    restart_pending = false;
+
     auto all_in_world = AccessWorld_QueryAllEntitiesWith<WorldPosition>().query();
     AccessWorld_ModifyWorld::destroy_entities(all_in_world.begin(), all_in_world.end());
 
@@ -583,7 +808,69 @@ void LevelCreationSystem::activate()
     calendar.hour = 7;
     calendar.minute = 0;
 
-    AccessWorld_UseUnique<Level>::access_unique().generate();
+    auto& level = AccessWorld_UseUnique<Level>::access_unique();
+
+    // a snapshot stands in for the generator once; the crafting on top runs from its seed as usual
+    bool loaded = false;
+    if (!load_path.empty())
+    {
+        loaded = load_level_snapshot(level, load_path.c_str());
+        if (loaded)
+        {
+            get_random().set_seed(level.seed);
+            map_width = level.width;
+            map_height = level.height;
+        }
+        else
+        {
+            printf("Could not load level snapshot %s, generating instead\n", load_path.c_str());
+        }
+
+        load_path.clear();
+    }
+
+    // pass this back in with --seed to get the same level, cast and plot
+    const auto seed = get_random().begin_level();
+    printf("Level seed: %llu\n", (unsigned long long)seed);
+
+    std::unique_ptr<Level> staged = stager.take();
+    const auto& colors = AccessWorld_UseUnique<Colors>::access_unique();
+    const auto config = LevelCache::config_key(colors);
+
+    // a staged level for any other seed (--seed, set after staging), size or colours (F2) is regenerated over.
+    // swapping rather than moving keeps the old level's buffers (fov map included) for reuse.
+    if (!loaded)
+    {
+        if (staged && staged->seed == seed && staged->width == map_width && staged->height == map_height
+            && LevelCache::config_key(staged->colors) == config)
+        {
+            std::swap(level, *staged);
+        }
+        else
+        {
+            level.colors = colors;
+            if (!cache.load(level, seed, map_width, map_height, config))
+            {
+                level.generate(seed, map_width, map_height, &arena);
+                cache.store(level, config);
+            }
+        }
+    }
+
+    if (!save_path.empty())
+    {
+        if (!save_level_snapshot(level, save_path.c_str()))
+        {
+            printf("Could not save level snapshot %s\n", save_path.c_str());
+        }
+
+        save_path.clear();
+    }
+
+    if (staged)
+    {
+        spare_level = std::move(staged);
+    }
 
     auto& pm = AccessWorld_UseUnique<PeopleMapping>::access_unique();
 
@@ -593,102 +880,301 @@ void LevelCreationSystem::activate()
     }
 
     AccessEvents_Emit<LevelCreationEvent>::emit_event();
+
+    stage_next_level();
+}
+
+void LevelCreationSystem::stage_next_level()
+{
+    // generation only touches the Level itself (no registry), so a worker can build it.
+    // the arena is only ever used by one generation at a time: activate() waits for this one first.
+    std::unique_ptr<Level> level = spare_level ? std::move(spare_level) : std::unique_ptr<Level>{ new Level };
+
+    const auto& colors = AccessWorld_UseUnique<Colors>::access_unique();
+    stager.start(std::move(level), get_random().peek_next_seed(), map_width, map_height, colors, &arena, &cache);
+}
+
+LevelStager::~LevelStager()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    changed.notify_all();
+
+    if (worker.joinable()) worker.join();
+}
+
+void LevelStager::start(std::unique_ptr<Level> level, uint64_t seed, int width, int height, const Colors& colors, LevelArena* arena, LevelCache* cache)
+{
+    // the colours are copied here, on the caller's thread, so F2 can change them while the worker runs
+    level->colors = colors;
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        this->level = std::move(level);
+        this->seed = seed;
+        this->width = width;
+        this->height = height;
+        this->arena = arena;
+        this->cache = cache;
+        queued = true;
+    }
+    changed.notify_all();
+
+    if (!worker.joinable()) worker = std::thread([this]() { work(); });
+}
+
+bool LevelStager::ready()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return !queued && !building;
+}
+
+std::unique_ptr<Level> LevelStager::take()
+{
+    std::unique_lock<std::mutex> guard(lock);
+    changed.wait(guard, [this]() { return !queued && !building; });
+    return std::move(level);
+}
+
+void LevelStager::work()
+{
+    std::unique_lock<std::mutex> guard(lock);
+    while (true)
+    {
+        changed.wait(guard, [this]() { return queued || stopping; });
+        if (stopping) return;
+
+        queued = false;
+        building = true;
+        guard.unlock();
+
+        // nothing else touches the level, arena or cache until building is cleared
+        const auto config = LevelCache::config_key(level->colors);
+        if (!cache->load(*level, seed, width, height, config))
+        {
+            level->generate(seed, width, height, arena);
+            cache->store(*level, config);
+        }
+
+        guard.lock();
+        building = false;
+        changed.notify_all();
+    }
+}
+
+void LevelCreationSystem::set_map_size(int width, int height)
+{
+    map_width = width;
+    map_height = height;
+}
+
+void LevelCreationSystem::set_load_path(const char* path)
+{
+    load_path = path;
+}
+
+void LevelCreationSystem::set_save_path(const char* path)
+{
+    save_path = path;
+}
+
+void LevelCreationSystem::set_cache_enabled(bool enabled)
+{
+    cache.enabled = enabled;
 }
 
 void LevelCreationSystem::react_to_event(KeyEvent& signal)
 {
     if (signal.key == KeyCode::KEY_F3)
     {
-        activate();
+        if (stager.ready())
+            activate();
+        else
+            restart_pending = true;
     }
 }
 
+void LevelCreationSystem::react_to_event(Tick&)
+{
+    if (!restart_pending || !stager.ready()) return;
+
+    restart_pending = false;
+    activate();
+    request_redraw();
+}
+
 void LevelRenderSystem::activate()
 {
-    static float dhues[MAP_WIDTH][MAP_HEIGHT]{ 0.0f, };
-    static float dsats[MAP_WIDTH][MAP_HEIGHT]{ 0.0f, };
-    static float dvals[MAP_WIDTH][MAP_HEIGHT]{ 0.0f, };
+    const auto step = frames_elapsed();
+    tick += step;
 
-    tick++;
+    bool shimmering = false;
+    bool fading = false;
 
-    TCODRandom* rng = TCODRandom::getInstance();
+    TCODRandom* rng = get_random().stream(RandomStream::Render);
     auto& level = AccessWorld_UseUnique<Level>::access_unique();
-    const auto& colors = AccessWorld_UseUnique<Colors>::access_unique();
+    const auto& colors = AccessWorld_UseUnique<const Colors>::access_unique();
     auto& player_fov = AccessWorld_UseUnique<PlayerFOV>::access_unique();
+    auto& camera = AccessWorld_UseUnique<Camera>::access_unique();
+
+    if (shades.get_width() != level.width || shades.get_height() != level.height)
+    {
+        shades.resize(level.width, level.height, Shade{});
+    }
+
+    // faded colours follow the level's chunks in and out of memory, packed when the level's are
+    if (shades_residency != level.residency_version)
+    {
+        shades.compress_except(level.chunk_keep);
+        shades_residency = level.residency_version;
+    }
 
-    const auto player_entity = AccessWorld_QueryAllEntitiesWith<Player>::query().front();
-    const auto& world_pos = AccessWorld_QueryComponent<WorldPosition>::get_component(player_entity);
-    const auto& sight = AccessWorld_QueryComponent<Sight>::get_component(player_entity);
+    const auto player_entity = AccessWorld_QueryAllEntitiesWith<const Player>::query().front();
+    const auto& world_pos = AccessWorld_QueryComponent<const WorldPosition>::get_component(player_entity);
+    const auto& sight = AccessWorld_QueryComponent<const Sight>::get_component(player_entity);
 
     const auto rad = (float)sight.radius;
     const auto rad2 = (float)sight.radius * 2;
 
-    player_fov.fields.clear();
+    // digging or filling within sight changes what the player can see
+    if (level.take_edits().near(world_pos, sight.radius))
+    {
+        level.compute_fov(world_pos.x, world_pos.y, sight.radius);
+    }
 
-    for (int i = 0; i < MAP_WIDTH; i++)
+    player_fov.reset(level.width, level.height);
+    camera.follow(world_pos, level.width, level.height);
+
+    // only the viewport is drawn; sight never reaches past it, so neither does the fov
+    const int view_right = std::min(camera.x + VIEW_WIDTH, level.width);
+    const int view_bottom = std::min(camera.y + VIEW_HEIGHT, level.height);
+
+    // a row's glyphs and foreground colours are gathered first, then converted in one batch
+    int glyphs[VIEW_WIDTH];
+    float hues[VIEW_WIDTH];
+    float sats[VIEW_WIDTH];
+    float vals[VIEW_WIDTH];
+    TCOD_ColorRGB fores[VIEW_WIDTH];
+    TCOD_ColorRGB backs[VIEW_WIDTH];
+    bool has_back[VIEW_WIDTH];
+
+    // row by row, the same order tiles, shades and the console are laid out in
+    for (int j = camera.y; j < view_bottom; j++)
     {
-        for (int j = 0; j < MAP_HEIGHT; j++)
+        int n = 0;
+        for (int i = camera.x; i < view_right; i++, n++)
         {
-            const auto scr = ScreenPosition{ i, j };
             const auto ij = WorldPosition{ i, j };
             const auto dist = world_pos.distance(ij);
 
-            if (level.map->isInFov(i, j) && dist < rad)
+            auto& tile = level.tile(i, j);
+            auto& shade = shades.at(i, j);
+
+            has_back[n] = false;
+
+            if (level.is_in_fov(i, j) && dist < rad)
             {
-                player_fov.fields.insert(ij);
+                player_fov.mark(i, j);
 
-                dhues[i][j] = level.hues[i][j];
-                dsats[i][j] = level.sats[i][j];
-                
-                dvals[i][j] = std::max(level.vals[i][j] * (1.0f - (dist / rad)), 0.33f);
+                shade.hue = tile.hue;
+                shade.sat = tile.sat;
+                shade.val = std::max(tile.val * (1.0f - (dist / rad)), 0.33f);
 
-                if (level.dig[i][j] == ' ')
+                hues[n] = shade.hue;
+                sats[n] = shade.sat;
+                vals[n] = shade.val;
+
+                if (tile.dig == ' ')
                 {
-                    AccessConsole::fg(scr, HSL(dhues[i][j], dsats[i][j], dvals[i][j]));
-                    AccessConsole::ch(scr, "#");
-                    level.memory[i][j] = '#';
+                    glyphs[n] = '#';
+                    tile.memory = '#';
                 }
-                else if (level.dig[i][j] == '*')
+                else if (tile.dig == '*')
                 {
+                    shimmering = true;
                     auto time_factor = std::sin((i + j) * colors.shimmer_stripe_width + tick * colors.shimmer_stripe_speed);
-                    auto h = dhues[i][j] + time_factor * colors.shimmer_stripe_strength;
+                    auto h = shade.hue + time_factor * colors.shimmer_stripe_strength;
                     auto s = 1.0f;
                     auto v = rng->getFloat(0.95f, 1.0f) * (rad - world_pos.distance(ij)) / rad2;
 
-                    bg(scr, HSL(h, s, v));
-                    AccessConsole::fg(scr, HSL(255.0f, 0.3f, 2 * (rad2 - world_pos.distance(ij)) / rad));
-                    level.memory[i][j] = '.';
-                    ch(scr, ".");
+                    hues[n] = 255.0f;
+                    sats[n] = 0.3f;
+                    vals[n] = 2 * (rad2 - world_pos.distance(ij)) / rad;
+                    backs[n] = hsl_to_rgb(h, s, v);
+                    has_back[n] = true;
+
+                    glyphs[n] = '.';
+                    tile.memory = '.';
                 }
                 else
                 {
-                    AccessConsole::fg(scr, HSL(dhues[i][j], dsats[i][j], dvals[i][j]));
-                    std::string s(1, level.dig[i][j]);
-                    level.memory[i][j] = level.dig[i][j];
-                    AccessConsole::ch(scr, s);
+                    glyphs[n] = (unsigned char)tile.dig;
+                    tile.memory = tile.dig;
                 }
             }
             else
             {
-                if (dsats[i][j] > 0.0f)
+                if (shade.sat > 0.0f)
                 {
-                    dsats[i][j] -= 0.00001f;
-                    if (dsats[i][j] < 0.0f)
-                        dsats[i][j] = 0.0f;
+                    fading = true;
+                    shade.sat -= 0.00001f * step;
+                    if (shade.sat < 0.0f)
+                        shade.sat = 0.0f;
                 }
 
-                if (dvals[i][j] > 0.00001f)
+                if (shade.val > 0.00001f)
                 {
-                    dvals[i][j] -= 0.00001f;
-                    if (dvals[i][j] < 0.33f)
-                        dvals[i][j] = 0.33f;
-                }
+                    const auto before = shade.val;
+                    shade.val -= 0.00001f * step;
+                    if (shade.val < 0.33f)
+                        shade.val = 0.33f;
 
-                AccessConsole::fg(scr, HSL(dhues[i][j], dsats[i][j], dvals[i][j]));
+                    // held at the floor, the tile has nothing left to animate
+                    fading = fading || shade.val != before;
+                }
 
-                std::string s(1, level.memory[i][j]);
-                AccessConsole::ch(scr, s);
+                hues[n] = shade.hue;
+                sats[n] = shade.sat;
+                vals[n] = shade.val;
+                glyphs[n] = (unsigned char)tile.memory;
             }
         }
+
+        hsl_to_rgb(hues, sats, vals, fores, n);
+
+        for (int k = 0; k < n; k++)
+        {
+            const auto scr = camera.to_screen(WorldPosition{ camera.x + k, j });
+            if (has_back[k])
+                put(scr, glyphs[k], fores[k], backs[k]);
+            else
+                put(scr, glyphs[k], fores[k]);
+        }
     }
+
+    // the shimmer moves every frame, faded memory only needs an occasional touch-up
+    if (shimmering)
+        request_animation_frame();
+    else if (fading)
+        request_animation_frame(MEMORY_FADE_FRAME_MS);
+}
+
+void LevelStreamingSystem::activate()
+{
+    auto& level = AccessWorld_UseUnique<Level>::access_unique();
+
+    active.clear();
+    for (auto&& [entity, world_pos] : AccessWorld_QueryAllEntitiesWith<const Player, const WorldPosition>::query().each())
+    {
+        active.push_back(world_pos);
+    }
+
+    for (auto&& [entity, _, world_pos] : AccessWorld_QueryAllEntitiesWith<const Person, const WorldPosition>::query().each())
+    {
+        active.push_back(world_pos);
+    }
+
+    level.update_residency(active);
 }
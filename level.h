@@ -1,69 +1,319 @@
 #pragma once
 
-#include <deque>
 #include <unordered_set>
-#include <bitset>
 #include <libtcod.hpp>
 #include <queue>
 #include <functional>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 #include "config.h"
 #include "common.h"
 
+#include "bitboard.h"
+#include "chunks.h"
+#include "corridors.h"
+#include "grid.h"
 #include "graphs.h"
+#include "labelling.h"
+#include "level_cache.h"
+#include "sampling.h"
+#include "spanning.h"
+#include "stamp.h"
 
 struct PeopleMapping;
 struct Person;
 
 struct LevelCreationEvent {};
 
+// the steps of Level::generate, in the order they first run
+enum class LevelStage : uint8_t
+{
+    Init,
+    Gradient,
+    Minesweep,
+    CellularAutomata,
+    RoomCounting,
+    Connect,
+    ForceConnect,
+    FloodFillRegions,
+    UpdateMapVisibility,
+    LinkTiles,
+    COUNT,
+};
+
+const char* get_level_stage_name(LevelStage stage);
+
+// told when each stage of a generate() call starts and ends; room counting runs twice
+struct LevelStageObserver
+{
+    virtual ~LevelStageObserver() {}
+    virtual void begin_stage(LevelStage stage) = 0;
+    virtual void end_stage(LevelStage stage) = 0;
+};
+
+// everything a cell keeps once the level is made, packed so a pass over a row reads one
+// record per cell instead of one element from each of six planes
+struct Tile
+{
+    float hue = 0.0f;
+    float sat = 0.0f;
+    float val = 0.0f;
+    char dig = ' ';
+    char memory = ' ';
+    char region = ' ';
+
+    bool operator==(const Tile& other) const
+    {
+        return hue == other.hue && sat == other.sat && val == other.val
+            && dig == other.dig && memory == other.memory && region == other.region;
+    }
+
+    // by field: the padding byte after region is never written
+    size_t hash() const
+    {
+        return CellHash().add(hue).add(sat).add(val).add(dig).add(memory).add(region).done();
+    }
+};
+
+// where a tile sits in the level's lists, so a runtime edit can drop it without searching them
+struct TileLinks
+{
+    int32_t walkable = -1;
+    int32_t room = -1;
+    int32_t room_slot = -1;
+    int32_t region_slot = -1;
+
+    bool operator==(const TileLinks& other) const
+    {
+        return walkable == other.walkable && room == other.room
+            && room_slot == other.room_slot && region_slot == other.region_slot;
+    }
+};
+
+// bounding box of the cells edited since the last take_edits(): [x0, x1) x [y0, y1)
+struct LevelEdits
+{
+    int x0 = 0;
+    int y0 = 0;
+    int x1 = 0;
+    int y1 = 0;
+
+    bool any() const { return x0 < x1 && y0 < y1; }
+
+    void add(int x, int y)
+    {
+        if (!any())
+        {
+            x0 = x; y0 = y; x1 = x + 1; y1 = y + 1;
+            return;
+        }
+
+        x0 = std::min(x0, x); y0 = std::min(y0, y);
+        x1 = std::max(x1, x + 1); y1 = std::max(y1, y + 1);
+    }
+
+    // whether any edited cell is within radius tiles of pos, on either axis
+    bool near(const WorldPosition& pos, int radius) const
+    {
+        return any() && pos.x >= x0 - radius && pos.x < x1 + radius && pos.y >= y0 - radius && pos.y < y1 + radius;
+    }
+};
+
+// the buffers generation digs in. a level borrows them for the length of generate() and hands
+// them back, so an arena kept across restarts stops allocating once it has seen a level that big.
+struct LevelArena
+{
+    Grid<float> digability;
+    Grid<int> rooms;
+
+    std::vector<bool> flood_fill_visited;
+    std::vector<bool> flood_fill_candidate;
+    std::vector<bool> bombs;
+    std::vector<XY> flood_fill_queue;
+    std::vector<XY> exploded_bombs;
+
+    DynamicBitboard cellular_board;
+    ComponentLabeller room_labeller;
+    SpanningTreeBuilder spanning;
+    CorridorCarver carver;
+    std::vector<WorldPosition> corridor_points;
+    std::vector<WorldPosition> corridor_cells;
+
+    PoissonDiskSampler sampler;
+
+    Stamp stamp;
+    std::vector<float> stamp_rolls;
+    std::vector<float> stamp_values;
+};
+
+// a fresh value for Level::residency_version
+int next_residency_version();
+
 struct Level
     : public AccessWorld_ModifyWorld
     , public AccessWorld_ModifyEntity
-    , public AccessWorld_UseUnique<Colors>
 {
-    TCODMap* map;
+    // the rock colours generate() paints with. a copy taken when generation is set up,
+    // so a level built on a worker never reads the Colors that F2 reloads on the main thread.
+    Colors colors;
     
-    float digability[MAP_WIDTH][MAP_HEIGHT] { 0.0f, };
-    char dig[MAP_WIDTH][MAP_HEIGHT]{ ' ', };
-    char memory[MAP_WIDTH][MAP_HEIGHT]{ ' ', };
+    // defaults to MAP_WIDTH x MAP_HEIGHT; generate() can size a level to anything
+    int width = MAP_WIDTH;
+    int height = MAP_HEIGHT;
+
+    // cold planes: scratch for digging, empty outside of generate()
+    LevelArena scratch;
 
-    float hues[MAP_WIDTH][MAP_HEIGHT]{ 0.0f };
-    float sats[MAP_WIDTH][MAP_HEIGHT]{ 0.0f };
-    float vals[MAP_WIDTH][MAP_HEIGHT]{ 0.0f };
+    // hot tiles: what the level keeps while played, in chunks that pack away out of everyone's reach
+    ChunkedGrid<Tile> terrain;
 
-    char rooms[MAP_WIDTH][MAP_HEIGHT]{ ' ', };
-    char regions[MAP_WIDTH][MAP_HEIGHT]{ ' ', };
+    // per chunk: near the player or a person as of the last update_residency, and a count
+    // that goes up whenever that changes, for anything chunked alongside the level
+    std::vector<bool> chunk_keep;
+    int residency_version = 0;
+
+    // what blocks sight and movement, per tile and chunked like the terrain: chunks of solid rock
+    // never allocate. fov runs on a window of it around the viewer, so there is no map-sized TCODMap.
+    static constexpr uint8_t OPEN_SIGHT = 1;
+    static constexpr uint8_t OPEN_WALK = 2;
+    ChunkedGrid<uint8_t> opacity;
+
+    // per tile, its slots in walkable, its room and its region; chunked like the terrain
+    ChunkedGrid<TileLinks> links;
+    LevelEdits edits;
 
     std::vector<WorldPosition> region_centers;
     std::vector<WorldPosition> region_tiles[REGION_COUNT];
 
-    int tiles_in_room[ROOM_COUNT] { 0, };
-    std::vector<WorldPosition> tiles[ROOM_COUNT];
+    // rooms kept by room_counting; the limit grows with the map's area
+    int room_limit = ROOM_COUNT;
+    std::vector<int> tiles_in_room;
+    std::vector<std::vector<WorldPosition>> tiles;
 
     std::vector<WorldPosition> walkable;
-    std::bitset<MAP_WIDTH * MAP_HEIGHT> flood_fill_visited;
-    std::bitset<MAP_WIDTH * MAP_HEIGHT> flood_fill_candidate;
-    std::bitset<MAP_WIDTH * MAP_HEIGHT> bombs;
-    std::vector<XY> exploded_bombs;
-    graphs::Graph dig_plan;
 
-    std::deque<XY> flood_fill_freelist;
+    // a level only draws from its own streams, so it can be generated off the main thread
+    uint64_t seed = 0;
+    SplitMixRandom terrain_rng;
+    SplitMixRandom region_rng;
 
     Level() {}
 
+    static constexpr int NO_ROOM = -1;
+
+    int index(int x, int y) const
+    {
+        return terrain.index(x, y);
+    }
+
+    Tile& tile(int x, int y)
+    {
+        return terrain.at(x, y);
+    }
+
+    // reads without unpacking the chunk
+    Tile peek(int x, int y) const
+    {
+        return terrain.get(x, y);
+    }
+
+    // the level's area over the default MAP_WIDTH x MAP_HEIGHT; scales how much gets dug
+    float area_scale() const
+    {
+        return (float)(width * height) / (MAP_WIDTH * MAP_HEIGHT);
+    }
+
+    void resize(int width, int height);
     void init();
     void gradient();
     void flood_fill(int bomb_count);
     void minesweep();
     void connect();
-    void cellular_automata();
-    void flood_fill_rooms(int start_x, int start_y, char current_room);
+    void cellular_automata(const CellularRule& rule = CA_PRUNE_ISOLATED, int passes = 1);
     void room_counting();
     void force_connect();
+    void carve_corridors();
     void flood_fill_regions();
-    void generate();
+    // digs in the arena's buffers when given one, otherwise in its own, which are freed afterwards
+    void generate(uint64_t seed, int width = MAP_WIDTH, int height = MAP_HEIGHT, LevelArena* arena = nullptr, LevelStageObserver* observer = nullptr);
     void update_map_visibility();
+
+    void set_properties(int x, int y, bool transparent, bool walkable);
+    bool is_transparent(int x, int y) const;
+    bool is_walkable(int x, int y) const;
+
+    // what can be seen from (x, y); is_in_fov answers for the last call
+    void compute_fov(int x, int y, int radius);
+    bool is_in_fov(int x, int y) const;
+
+    // fills in links from the lists; runs after generating or loading a level
+    void link_tiles();
+
+    // runtime edits: digging opens a wall tile, filling walls up an open one. each updates the
+    // fov map, the walkable list, and room and region membership for that tile alone. a dig next to
+    // two rooms merges them (the smaller moves); a fill never splits a room, even when it cuts one in two.
+    void dig(int x, int y, char floor = '.');
+    void fill(int x, int y);
+    void dig_rect(int x0, int y0, int x1, int y1, char floor = '.');
+    void fill_rect(int x0, int y0, int x1, int y1);
+
+    // the edits since the last call, for whoever keeps something derived from the tiles
+    LevelEdits take_edits();
+
+    // packs every chunk further than CHUNK_KEEP_RADIUS from all of the active positions. only does
+    // anything when that set of chunks changed since the last call; returns whether it did.
+    bool update_residency(const std::vector<WorldPosition>& active);
+    size_t memory_used() const;
+
+private:
+    // the window compute_fov last ran on, and its top-left tile; it only grows, with the radius
+    std::unique_ptr<TCODMap> fov_map;
+    int fov_x = 0;
+    int fov_y = 0;
+
+    std::vector<bool> next_keep;
+
+    void unlink(std::vector<WorldPosition>& list, int slot, int32_t TileLinks::* field);
+    int free_room();
+    void merge_room(int from, int into);
+};
+
+// builds the next level on one thread that lives as long as the stager, so staging a level
+// doesn't start a thread each time. holds at most one level, queued, being built or done.
+struct LevelStager
+{
+    ~LevelStager();
+
+    // hands the level over to be loaded from the cache or generated. arena and cache are
+    // only touched by the worker until take() returns.
+    void start(std::unique_ptr<Level> level, uint64_t seed, int width, int height, const Colors& colors, LevelArena* arena, LevelCache* cache);
+
+    // waits for the level given to start() and hands it back; null if there is none
+    std::unique_ptr<Level> take();
+
+    // whether take() would return without waiting
+    bool ready();
+
+private:
+    std::thread worker;
+    std::mutex lock;
+    std::condition_variable changed;
+
+    std::unique_ptr<Level> level;
+    uint64_t seed = 0;
+    int width = 0;
+    int height = 0;
+    LevelArena* arena = nullptr;
+    LevelCache* cache = nullptr;
+
+    bool queued = false;
+    bool building = false;
+    bool stopping = false;
+
+    void work();
 };
 
 struct LevelCreationSystem
@@ -73,10 +323,13 @@ struct LevelCreationSystem
     , public AccessWorld_UseUnique<PeopleMapping>
     , public AccessWorld_QueryAllEntitiesWith<Person>
     , public AccessWorld_QueryAllEntitiesWith<WorldPosition>
+    , public AccessWorld_UseUnique<Colors>
     , public AccessEvents_Listen<KeyEvent>
+    , public AccessEvents_Listen<Tick>
     , public AccessEvents_Emit<LevelCreationEvent>
     , public AccessWorld_ModifyWorld
     , public AccessWorld_ModifyEntity
+    , public AccessResource_Redraw
     , public AccessYAML
 {    
     template<typename T>
@@ -89,9 +342,44 @@ struct LevelCreationSystem
 
     void activate() override;
     void react_to_event(KeyEvent& signal) override;
+    void react_to_event(Tick& signal) override;
+
+    // size of every level made from now on, staged ones included
+    void set_map_size(int width, int height);
+
+    // the first level comes from this snapshot instead of the generator; its seed and size carry on from there
+    void set_load_path(const char* path);
+    // the first level is written out as a snapshot once made
+    void set_save_path(const char* path);
+
+    // on by default; levels are then looked up before they are generated, and kept once they are
+    void set_cache_enabled(bool enabled);
 
 private:
     std::vector<std::shared_ptr<CraftingPipeline>> pipeline;
+
+    int map_width = MAP_WIDTH;
+    int map_height = MAP_HEIGHT;
+
+    std::string load_path;
+    std::string save_path;
+
+    // the level swapped out by the last restart, rebuilt in place as the next staged one
+    std::unique_ptr<Level> spare_level;
+    LevelArena arena;
+
+    // like the arena, used by one level at a time: the staged one, or activate() once it's in
+    LevelCache cache;
+
+    // the next level, built in the background while this one is played. declared last, so its
+    // worker is joined before the arena and cache it uses go away.
+    LevelStager stager;
+
+    // F3 came in while the staged level was still being built; the restart waits for it on a
+    // later tick rather than blocking the frame
+    bool restart_pending = false;
+
+    void stage_next_level();
 };
 
 using PlaceWeight = std::tuple<std::string, int>;
@@ -112,14 +400,49 @@ struct LevelRenderSystem
     : public RuntimeSystem
     , public AccessConsole
     , public AccessYAML
-    , public AccessWorld_QueryComponent<WorldPosition>
-    , public AccessWorld_QueryComponent<Sight>
+    , public AccessWorld_QueryComponent<const WorldPosition>
+    , public AccessWorld_QueryComponent<const Sight>
     , public AccessWorld_UseUnique<Level>
-    , public AccessWorld_UseUnique<Colors>
+    , public AccessWorld_UseUnique<const Colors>
     , public AccessWorld_UseUnique<PlayerFOV>
-    , public AccessWorld_QueryAllEntitiesWith<Player>
+    , public AccessWorld_UseUnique<Camera>
+    , public AccessWorld_QueryAllEntitiesWith<const Player>
+    , public AccessResource_Redraw
 {
-    int tick;
+    float tick = 0.0f;
+
+    // what's on screen per cell, fading out once it leaves sight
+    struct Shade
+    {
+        float hue = 0.0f;
+        float sat = 0.0f;
+        float val = 0.0f;
+
+        bool operator==(const Shade& other) const
+        {
+            return hue == other.hue && sat == other.sat && val == other.val;
+        }
+
+        size_t hash() const
+        {
+            return CellHash().add(hue).add(sat).add(val).done();
+        }
+    };
+
+    ChunkedGrid<Shade> shades;
+    int shades_residency = -1;
 
     void activate() override;
 };
+
+struct LevelStreamingSystem
+    : public RuntimeSystem
+    , public AccessWorld_UseUnique<Level>
+    , public AccessWorld_QueryAllEntitiesWith<const Player, const WorldPosition>
+    , public AccessWorld_QueryAllEntitiesWith<const Person, const WorldPosition>
+{
+    void activate() override;
+
+private:
+    std::vector<WorldPosition> active;
+};
@@ -0,0 +1,106 @@
+#include "level_cache.h"
+
+#include "level.h"
+#include "random.h"
+#include "snapshot.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// bump when generate() changes what it makes from a seed, so old entries stop matching
+static constexpr uint64_t GENERATOR_VERSION = 3;
+
+static uint64_t float_bits(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+uint64_t LevelCache::config_key(const Colors& colors)
+{
+    const uint64_t parameters[]{
+        GENERATOR_VERSION,
+        MAP_WIDTH, MAP_HEIGHT,
+        ROOM_COUNT, MIN_TILES_PER_ROOM, CORRIDOR_SWEEP_MIN_POINTS,
+        REGION_COUNT, REGION_SPACING, REGION_RADIUS_MAX,
+        float_bits(colors.visible_hue), float_bits(colors.visible_sat),
+    };
+
+    uint64_t key = 0;
+    for (const auto parameter : parameters) key = split_seed(key, parameter);
+    return key;
+}
+
+std::string LevelCache::path_for(uint64_t seed, int width, int height, uint64_t config) const
+{
+    char name[96];
+    snprintf(name, sizeof(name), "%llu-%dx%d-%016llx.lvl", (unsigned long long)seed, width, height, (unsigned long long)config);
+    return (fs::path(directory) / name).string();
+}
+
+bool LevelCache::load(Level& level, uint64_t seed, int width, int height, uint64_t config)
+{
+    if (!enabled) return false;
+
+    const auto path = path_for(seed, width, height, config);
+    if (!load_level_snapshot(level, path.c_str())) return false;
+    if (level.seed != seed || level.width != width || level.height != height) return false;
+
+    // a hit counts as a use
+    std::error_code error;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), error);
+    return true;
+}
+
+void LevelCache::store(const Level& level, uint64_t config)
+{
+    if (!enabled) return;
+
+    std::error_code error;
+    fs::create_directories(directory, error);
+
+    // written aside and renamed, so a crash never leaves half a file under the real name
+    const auto path = path_for(level.seed, level.width, level.height, config);
+    const auto partial = path + ".tmp";
+    if (!save_level_snapshot(level, partial.c_str()))
+    {
+        fs::remove(partial, error);
+        return;
+    }
+
+    fs::rename(partial, path, error);
+    if (error)
+    {
+        fs::remove(partial, error);
+        return;
+    }
+
+    evict();
+}
+
+void LevelCache::evict()
+{
+    std::error_code error;
+    std::vector<std::pair<fs::file_time_type, fs::path>> entries;
+
+    for (fs::directory_iterator it(directory, error), end; !error && it != end; it.increment(error))
+    {
+        if (it->path().extension() != ".lvl") continue;
+        entries.push_back({ it->last_write_time(error), it->path() });
+    }
+
+    if ((int)entries.size() <= LEVEL_CACHE_ENTRIES) return;
+
+    std::sort(entries.begin(), entries.end());
+    for (size_t i = 0; i < entries.size() - LEVEL_CACHE_ENTRIES; i++)
+    {
+        fs::remove(entries[i].second, error);
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "config.h"
+
+struct Level;
+
+// finished levels on disk as snapshots, keyed by seed, size and a fingerprint of everything that
+// shapes generation (config.h and the rock colours). a hit is one mapped file instead of a generate();
+// past LEVEL_CACHE_ENTRIES files the least recently used go. one user at a time.
+struct LevelCache
+{
+    bool enabled = true;
+    std::string directory = LEVEL_CACHE_DIR;
+
+    static uint64_t config_key(const Colors& colors);
+
+    // false on a miss, or a file that doesn't match; the level may then hold anything and needs generating
+    bool load(Level& level, uint64_t seed, int width, int height, uint64_t config);
+    void store(const Level& level, uint64_t config);
+
+private:
+    std::string path_for(uint64_t seed, int width, int height, uint64_t config) const;
+    void evict();
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "common.h"
+
+// whole planes of hue, saturation and lightness to packed colours in one loop; hsl_to_rgb has
+// no branches, so the compiler converts several cells per instruction
+inline void hsl_to_rgb(const float* hue, const float* sat, const float* lit, TCOD_ColorRGB* out, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        out[i] = hsl_to_rgb(hue[i], sat[i], lit[i]);
+    }
+}
+
+// every colour of one lightness, with hue quantised to whole degrees and saturation to
+// 1/SATURATION_STEPS: a lookup in place of a conversion for fixed palettes such as fog
+struct HSLTable
+{
+    static constexpr int HUES = 360;
+    static constexpr int SATURATION_STEPS = 64;
+
+    // rebuilds only when the lightness changes
+    void build(float lightness)
+    {
+        if (lightness == this->lightness && !table.empty()) return;
+        this->lightness = lightness;
+
+        std::vector<float> hue(HUES * (SATURATION_STEPS + 1));
+        std::vector<float> sat(hue.size());
+        std::vector<float> lit(hue.size(), lightness);
+
+        for (int h = 0; h < HUES; h++)
+        {
+            for (int s = 0; s <= SATURATION_STEPS; s++)
+            {
+                hue[h * (SATURATION_STEPS + 1) + s] = (float)h;
+                sat[h * (SATURATION_STEPS + 1) + s] = (float)s / SATURATION_STEPS;
+            }
+        }
+
+        table.resize(hue.size());
+        hsl_to_rgb(hue.data(), sat.data(), lit.data(), table.data(), (int)table.size());
+    }
+
+    TCOD_ColorRGB at(float hue, float sat) const
+    {
+        int h = (int)std::lround(hue) % HUES;
+        if (h < 0) h += HUES;
+        const int s = std::min(std::max((int)std::lround(sat * SATURATION_STEPS), 0), SATURATION_STEPS);
+        return table[h * (SATURATION_STEPS + 1) + s];
+    }
+
+    float get_lightness() const { return lightness; }
+
+private:
+    float lightness = -1.0f;
+    std::vector<TCOD_ColorRGB> table;
+};
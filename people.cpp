@@ -5,7 +5,7 @@
 
 #include <yaml-cpp/yaml.h>
 
-std::vector<Entity> PeopleMapping::get_all_places_shuffled()
+std::vector<Entity> PeopleMapping::get_all_places_shuffled(TCODRandom* rng)
 {
     std::vector<Entity> places;
 
@@ -14,11 +14,11 @@ std::vector<Entity> PeopleMapping::get_all_places_shuffled()
         places.push_back(this->places[i]);
     }
 
-    shuffle(places);
+    shuffle(places, rng);
     return places;
 }
 
-std::vector<Entity> PeopleMapping::get_all_people_shuffled()
+std::vector<Entity> PeopleMapping::get_all_people_shuffled(TCODRandom* rng)
 {
     std::vector<Entity> people;
     
@@ -27,7 +27,7 @@ std::vector<Entity> PeopleMapping::get_all_people_shuffled()
         people.push_back(this->people[i]);
     }
 
-    shuffle(people);
+    shuffle(people, rng);
     return people;
 }
 
@@ -158,7 +158,7 @@ void PeopleMapping::connect(Entity a, Entity b, std::string label, int event_id)
 
 void populate_queues(YAML::Node places_yaml, std::unordered_map<std::string, PlaceWeightQueue>& queues)
 {
-    TCODRandom* rng = TCODRandom::getInstance();
+    TCODRandom* rng = get_random().stream(RandomStream::Population);
 
     for (auto key : {
     "few-work-no-visits",
@@ -191,7 +191,7 @@ void PopulationCrafting::generate_people_graph()
     auto& people = peopleMapping.people;
     auto& graph = peopleMapping.graph;
 
-    TCODRandom* rng = TCODRandom::getInstance();
+    TCODRandom* rng = get_random().stream(RandomStream::Population);
     std::unordered_set<int> used_places;
 
     for (int i = 0; i < REGION_COUNT; i++)
@@ -334,11 +334,6 @@ void PopulationCrafting::execute_crafting()
 {
     auto& peopleMapping = AccessWorld_UseUnique<PeopleMapping>::access_unique();
 
-    std::unordered_set<int> used_spaces;
-
-    TCODRandom* rng = TCODRandom::getInstance();
-
-    AccessWorld_UseUnique<Level>::access_unique().generate();
     auto& people_mapping = AccessWorld_UseUnique<PeopleMapping>::access_unique();
     people_mapping.graph.reset();
 
@@ -354,9 +349,20 @@ void PopulationCrafting::execute_crafting()
     std::vector<char> letters{ 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'r', 's', 't', 'u', 'w', 'v', 'y' };
 
     auto& level = AccessWorld_UseUnique<Level>::access_unique();
+
+    // one draw per region, keyed past the person ids so it never shares a stream with someone
+    int spawns_taken[REGION_COUNT]{};
+    for (int region = 0; region < REGION_COUNT; region++)
+    {
+        TCODRandom* spawn_rng = get_random().substream(RandomStream::Population, PEOPLE_COUNT + region);
+        sampler.sample(level.region_tiles[region], SPAWN_SPACING, spawn_rng, spawns[region]);
+    }
+
     for (auto person : people_mapping.people)
     {
         const int person_id = people_mapping.graph->get_tag<Person>(person).person_id;
+        TCODRandom* person_rng = get_random().substream(RandomStream::Population, person_id);
+
         for (auto edge : people_mapping.graph->get_all_edges(person))
         {
             if (people_mapping.graph->has_tag<LivesIn>(edge))
@@ -364,14 +370,19 @@ void PopulationCrafting::execute_crafting()
                 auto place_node = people_mapping.graph->get_target(edge);
                 const int region = people_mapping.graph->get_tag<Place>(place_node).place_id;
 
-                auto& tile = level.region_tiles[region][rng->getInt(0, level.region_tiles[region].size() - 1)];
-                while (used_spaces.count(TO_XY(tile.x, tile.y) > 0)) {
-                    tile = level.region_tiles[region][rng->getInt(0, level.region_tiles[region].size() - 1)];
-                }
-
-                used_spaces.insert(TO_XY(tile.x, tile.y));
+                // more residents than spawns only on tiny regions; they double up from the first.
+                // a region that got no tiles at all has no spawns, so they go to its centre instead,
+                // or anywhere walkable if the map had no room for that region either
+                const auto& region_spawns = spawns[region];
+                WorldPosition tile;
+                if (!region_spawns.empty())
+                    tile = region_spawns[spawns_taken[region]++ % region_spawns.size()];
+                else if (region < (int)level.region_centers.size())
+                    tile = level.region_centers[region];
+                else
+                    tile = level.walkable[person_id % level.walkable.size()];
 
-                Sex sex = (rng->getInt(0, 101) >= 50 ? Sex::Female : Sex::Male);
+                Sex sex = (person_rng->getInt(0, 101) >= 50 ? Sex::Female : Sex::Male);
 
                 // create person
 
@@ -380,17 +391,17 @@ void PopulationCrafting::execute_crafting()
                 AccessWorld_ModifyEntity::add_component<Sex>(game_person, sex);
                 AccessWorld_ModifyEntity::add_component<Health>(game_person, 100, 100);
                 AccessWorld_ModifyEntity::add_component<ActionPoints>(game_person, 0);
-                AccessWorld_ModifyEntity::add_component<Speed>(game_person, rng->getInt(80, 110));
+                AccessWorld_ModifyEntity::add_component<Speed>(game_person, person_rng->getInt(80, 110));
 
                 auto job = people_mapping.graph->get_tag<Job>(person).role;
                 AccessWorld_ModifyEntity::add_component<Job>(game_person, job);
-                int letter_index = rng->getInt(0, letters.size() - 1);
+                int letter_index = person_rng->getInt(0, letters.size() - 1);
                 char c = letters[letter_index];
                 std::string s_low(1, c);
                 letters.erase(letters.begin() + letter_index);
 
                 YAML::Node name_list = (sex == Sex::Female ? female_name_list : male_name_list)[s_low];
-                int name_index = rng->getInt(0, name_list.size() - 1);
+                int name_index = person_rng->getInt(0, name_list.size() - 1);
                 auto name = name_list[name_index].as<std::string>();
                 name_list.remove(name_index);
                 people_mapping.graph->label_node(person, name + "(" + job + ")");
@@ -2,6 +2,7 @@
 
 #include "common.h"
 #include "engine.h"
+#include "sampling.h"
 
 struct Level;
 
@@ -16,4 +17,8 @@ struct PopulationCrafting
 {
     void generate_people_graph();
     void execute_crafting() override;
+
+    // spread-out spawn tiles per region, handed to residents in turn
+    PoissonDiskSampler sampler;
+    std::vector<WorldPosition> spawns[REGION_COUNT];
 };
\ No newline at end of file
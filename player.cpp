@@ -17,10 +17,10 @@ void PlayerCreationSystem::react_to_event(LevelCreationEvent& signal)
         destroy_entity(last_player_entity);
     }
 
-    TCODRandom* rng = TCODRandom::getInstance();
+    TCODRandom* rng = get_random().stream(RandomStream::Player);
     last_player_entity = create_entity();
 
-    const auto& level = AccessWorld_UseUnique<Level>::access_unique();
+    auto& level = AccessWorld_UseUnique<Level>::access_unique();
     const auto size = level.walkable.size();
     const auto pos = level.walkable[rng->getInt(0, size)];
 
@@ -64,7 +64,7 @@ void PlayerCreationSystem::react_to_event(LevelCreationEvent& signal)
 
     auto& sight = add_component<Sight>(last_player_entity, ATTRIBUTE_SIGHT_NORM);
 
-    level.map->computeFov(pos.x, pos.y, sight.radius, true, FOV_RESTRICTIVE);
+    level.compute_fov(pos.x, pos.y, sight.radius);
 }
 
 void PlayerChoiceSystem::react_to_event(AwaitingActionSignal& signal)
@@ -76,6 +76,28 @@ void PlayerChoiceSystem::react_to_event(AwaitingActionSignal& signal)
     }
 }
 
+void PlayerChoiceSystem::activate()
+{
+    // without a keyboard, the detective wanders like everyone else, one action per frame
+    if (!is_headless() || !player_turn)
+        return;
+
+    const auto player = AccessWorld_QueryAllEntitiesWith<Player>::query().front();
+    const auto& world_pos = AccessWorld_QueryComponent<WorldPosition>::get_component(player);
+
+    TCODRandom* rng = get_random().stream(RandomStream::Player);
+
+    IssueCommandSignal issue;
+    issue.subject = player;
+    issue.type = CommandType::Move;
+    issue.data.move.from_x = world_pos.x;
+    issue.data.move.from_y = world_pos.y;
+    issue.data.move.to_x = world_pos.x + rng->getInt(-1, 1);
+    issue.data.move.to_y = world_pos.y + rng->getInt(-1, 1);
+
+    issue_command(issue);
+}
+
 void PlayerChoiceSystem::issue_command(IssueCommandSignal issue)
 {
     player_turn = false;
@@ -33,9 +33,11 @@ struct PlayerChoiceSystem
     , public AccessEvents_Listen<AwaitingActionSignal>
     , public AccessEvents_Listen<KeyEvent>
     , public AccessEvents_Emit<IssueCommandSignal>
+    , public AccessResource_Headless
 {
     bool player_turn = false;
 
+    void activate() override;
     void react_to_event(AwaitingActionSignal& signal) override;
     void react_to_event(KeyEvent& key) override;
 
@@ -6,7 +6,7 @@ void PlotCrafting::execute_crafting()
 {
     auto& people_mapping = AccessWorld_UseUnique<PeopleMapping>::access_unique();
 
-    TCODRandom* rng = TCODRandom::getInstance();
+    TCODRandom* rng = get_random().stream(RandomStream::Plot);
 
     int event_id = 0;
     int size = (int)social_interactions.size();
@@ -21,7 +21,7 @@ void PlotCrafting::execute_crafting()
         if (i != murder_index)
             social_interactions[i](people_mapping, event_id++, entt::null, false);
 
-    auto people = people_mapping.get_all_people_shuffled();
+    auto people = people_mapping.get_all_people_shuffled(rng);
     for (int i = 0; i < size; i++)
     {
         social_interactions[i](people_mapping, event_id++, people.back(), false);
@@ -19,13 +19,75 @@
 #include "plot.h"
 #include "world.h"
 
+#include <chrono>
+#include <cstring>
+
 #undef main
 
 int main(int argc, char* argv[])
 {
-    PoirogueEngine engine;
+    bool headless = false;
+    long frame_limit = -1;
+    const char* trace_path = nullptr;
+    bool idle_throttle = true;
+    int map_width = MAP_WIDTH;
+    int map_height = MAP_HEIGHT;
+    const char* load_level_path = nullptr;
+    const char* save_level_path = nullptr;
+    bool level_cache = true;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--headless") == 0)
+        {
+            headless = true;
+        }
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+        {
+            frame_limit = atol(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+        {
+            trace_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--always-redraw") == 0)
+        {
+            idle_throttle = false;
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            get_random().set_seed(strtoull(argv[++i], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--map-size") == 0 && i + 1 < argc)
+        {
+            // WxH; anything smaller than the viewport would leave part of it empty
+            if (sscanf(argv[++i], "%dx%d", &map_width, &map_height) != 2 || map_width < VIEW_WIDTH || map_height < VIEW_HEIGHT)
+            {
+                printf("--map-size expects WxH of at least %dx%d\n", VIEW_WIDTH, VIEW_HEIGHT);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--load-level") == 0 && i + 1 < argc)
+        {
+            load_level_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--save-level") == 0 && i + 1 < argc)
+        {
+            save_level_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--no-level-cache") == 0)
+        {
+            level_cache = false;
+        }
+    }
+
+    PoirogueEngine engine(headless);
     
     auto level_creation = engine.add_one_off_system<LevelCreationSystem>();
+    level_creation->set_map_size(map_width, map_height);
+    if (load_level_path) level_creation->set_load_path(load_level_path);
+    if (save_level_path) level_creation->set_save_path(save_level_path);
+    level_creation->set_cache_enabled(level_cache);
     level_creation->add_pipeline<PopulationCrafting>();
 
     auto plot = level_creation->add_pipeline<PlotCrafting>();    
@@ -35,7 +97,7 @@ int main(int argc, char* argv[])
 
     engine.add_one_off_system<PlayerCreationSystem>();
     engine.add_one_off_system<Debug_ReloadConfigSystem>();
-    engine.add_one_off_system<TimeSystem>();
+    auto time_system = engine.add_one_off_system<TimeSystem>();
 
     engine.add_one_off_system<BlockMovementThroughPeopleSystem>(); // todo: create bump commands?
 
@@ -45,20 +107,60 @@ int main(int argc, char* argv[])
     interp->add_interpreter<CommandType::Unlock>(new UnlockCommandInterpreter);
     interp->add_interpreter<CommandType::Inspect>(new InspectCommandInterpreter);
 
-    engine.add_runtime_system<LevelRenderSystem>();
-    engine.add_runtime_system<SymbolRenderSystem>();
+    if (!headless)
+    {
+        engine.add_runtime_system<LevelRenderSystem>();
+        engine.add_runtime_system<SymbolRenderSystem>();
+    }
+
     engine.add_runtime_system<PlayerChoiceSystem>();
     engine.add_runtime_system<AIChoiceSystem>();
-    engine.add_runtime_system<Debug_TurnOrderSystem>();        
-    engine.add_runtime_system<HUDSystem>();
-    engine.add_runtime_system<MouseCursorSystem>();
+    engine.add_runtime_system<LevelStreamingSystem>();
+
+    if (!headless)
+    {
+        engine.add_runtime_system<Debug_TurnOrderSystem>();
+        engine.add_runtime_system<HUDSystem>();
+        engine.add_runtime_system<Debug_ProfilerSystem>();
+        engine.add_runtime_system<MouseCursorSystem>();
+    }
 
+    engine.set_idle_throttle(idle_throttle);
     engine.restart_game();
+
+    long frames = 0;
+    const auto started = std::chrono::steady_clock::now();
     
     while (engine) {
-        engine.start_frame();
         engine.poll_events();
+
+        // an idle iteration draws nothing, but time still passes and the frame still ends
+        if (!engine.frame_pending())
+        {
+            engine.end_frame(false);
+            continue;
+        }
+
+        engine.start_frame();
         engine.run_systems();
         engine.end_frame();
+
+        frames++;
+        if (frame_limit >= 0 && frames >= frame_limit)
+        {
+            engine.quit();
+        }
+    }
+
+    if (headless)
+    {
+        const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        const long turns = time_system->turns_taken;
+        printf("%ld turns over %ld frames in %.3fs (%.1f turns/s)\n", turns, frames, elapsed, elapsed > 0.0 ? turns / elapsed : 0.0);
+    }
+
+    if (trace_path != nullptr)
+    {
+        get_profiler().dump_chrome_trace(trace_path);
     }
 }
@@ -0,0 +1,140 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+using namespace std::chrono;
+
+std::string clean_type_name(const char* name)
+{
+    std::string result = name;
+
+    // msvc spells out the class-key, i.e. "struct LevelRenderSystem"
+    for (const char* prefix : { "struct ", "class " })
+    {
+        size_t at = 0;
+        while ((at = result.find(prefix, at)) != std::string::npos)
+        {
+            result.erase(at, strlen(prefix));
+        }
+    }
+
+    return result;
+}
+
+Profiler::Profiler()
+    : epoch{ ProfileClock::now() }
+{
+    trace.resize(PROFILER_TRACE_CAPACITY);
+}
+
+static int current_thread_index()
+{
+    static std::atomic<int> next_index{ 1 };
+    static thread_local int index = next_index++;
+    return index;
+}
+
+int Profiler::register_scope(const std::string& name)
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    auto found = scope_index.find(name);
+    if (found != scope_index.end())
+        return found->second;
+
+    int index = (int)stats.size();
+    stats.push_back(ProfileStat{ name });
+    scope_index.insert({ name, index });
+    return index;
+}
+
+void Profiler::record(int scope, ProfileClock::time_point start, ProfileClock::time_point end)
+{
+    if (!enabled || scope < 0) return;
+
+    const auto ms = duration<double, std::milli>(end - start).count();
+
+    std::lock_guard<std::mutex> guard(lock);
+
+    auto& stat = stats[scope];
+    stat.last_ms = ms;
+    stat.total_ms += ms;
+    stat.max_ms = std::max(stat.max_ms, ms);
+    stat.samples++;
+
+    auto& event = trace[trace_head];
+    event.scope = scope;
+    event.thread = current_thread_index();
+    event.start_us = duration_cast<microseconds>(start - epoch).count();
+    event.duration_us = duration_cast<microseconds>(end - start).count();
+
+    trace_head++;
+    if (trace_head == trace.size())
+    {
+        trace_head = 0;
+        trace_wrapped = true;
+    }
+}
+
+std::vector<ProfileStat> Profiler::get_stats()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return stats;
+}
+
+void Profiler::reset()
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    for (auto& stat : stats)
+    {
+        stat.last_ms = 0.0;
+        stat.total_ms = 0.0;
+        stat.max_ms = 0.0;
+        stat.samples = 0;
+    }
+}
+
+static void write_json_string(FILE* file, const std::string& text)
+{
+    fputc('"', file);
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\') fputc('\\', file);
+        fputc(c, file);
+    }
+    fputc('"', file);
+}
+
+bool Profiler::dump_chrome_trace(const char* path) const
+{
+    FILE* file = fopen(path, "w");
+    if (file == nullptr) return false;
+
+    fprintf(file, "{\"traceEvents\":[\n");
+
+    const size_t count = trace_wrapped ? trace.size() : trace_head;
+    const size_t first = trace_wrapped ? trace_head : 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const auto& event = trace[(first + i) % trace.size()];
+
+        fprintf(file, "%s{\"name\":", i == 0 ? "" : ",\n");
+        write_json_string(file, stats[event.scope].name);
+        fprintf(file, ",\"cat\":\"poirogue\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%lld,\"dur\":%lld}", event.thread, event.start_us, event.duration_us);
+    }
+
+    fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    fclose(file);
+    return true;
+}
+
+Profiler& get_profiler()
+{
+    static Profiler profiler;
+    return profiler;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define PROFILER_TRACE_CAPACITY (1 << 16)
+
+using ProfileClock = std::chrono::steady_clock;
+
+std::string clean_type_name(const char* name);
+
+struct ProfileStat
+{
+    std::string name;
+    double last_ms = 0.0;
+    double total_ms = 0.0;
+    double max_ms = 0.0;
+    long samples = 0;
+
+    double avg_ms() const
+    {
+        return samples > 0 ? total_ms / samples : 0.0;
+    }
+};
+
+struct ProfileTraceEvent
+{
+    int scope;
+    int thread;
+    long long start_us;
+    long long duration_us;
+};
+
+struct Profiler
+{
+    bool enabled = true;
+
+    Profiler();
+
+    int register_scope(const std::string& name);
+    void record(int scope, ProfileClock::time_point start, ProfileClock::time_point end);
+    void reset();
+
+    std::vector<ProfileStat> get_stats();
+
+    // writes the trace ring buffer as a chrome://tracing (trace_event) JSON file
+    bool dump_chrome_trace(const char* path) const;
+
+private:
+    ProfileClock::time_point epoch;
+    std::mutex lock;
+    std::unordered_map<std::string, int> scope_index;
+    std::vector<ProfileStat> stats;
+
+    std::vector<ProfileTraceEvent> trace;
+    size_t trace_head = 0;
+    bool trace_wrapped = false;
+};
+
+Profiler& get_profiler();
+
+struct ProfileScope
+{
+    explicit ProfileScope(int scope)
+        : scope(scope)
+        , start(ProfileClock::now())
+    {}
+
+    ~ProfileScope()
+    {
+        get_profiler().record(scope, start, ProfileClock::now());
+    }
+
+private:
+    int scope;
+    ProfileClock::time_point start;
+};
@@ -0,0 +1,141 @@
+#include "random.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <utility>
+
+static constexpr uint64_t GOLDEN_GAMMA = 0x9E3779B97F4A7C15ull;
+
+static uint64_t mix(uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+uint64_t split_seed(uint64_t seed, uint64_t salt)
+{
+    return mix(seed + (salt + 1) * GOLDEN_GAMMA);
+}
+
+uint64_t SplitMixRandom::next()
+{
+    state += GOLDEN_GAMMA;
+    return mix(state);
+}
+
+int SplitMixRandom::getInt(int min, int max)
+{
+    if (max < min) std::swap(min, max);
+
+    // the modulo bias of a 64-bit draw over an int range is far below anything a level could show
+    const uint64_t range = (uint64_t)((int64_t)max - min) + 1;
+    return (int)((int64_t)min + (int64_t)(next() % range));
+}
+
+float SplitMixRandom::getFloat(float min, float max)
+{
+    // 24 random bits over [0, 1], so both ends can come up
+    const float unit = (float)(next() >> 40) / (float)((1 << 24) - 1);
+    return min + (max - min) * unit;
+}
+
+float SplitMixRandom::getFloat(float min, float max, float mean)
+{
+    const float deviation = std::max(mean - min, max - mean) / 3.0f;
+
+    // box-muller; the first draw is kept off zero for the log
+    const float u = ((float)(next() >> 40) + 1.0f) / (float)(1 << 24);
+    const float v = (float)(next() >> 40) / (float)(1 << 24);
+    const float normal = std::sqrt(-2.0f * std::log(u)) * std::cos(6.2831853f * v);
+
+    return std::clamp(mean + normal * deviation, min, max);
+}
+
+static uint32_t tcod_seed(uint64_t seed)
+{
+    return (uint32_t)(seed ^ (seed >> 32));
+}
+
+void reseed_stream(TCODRandom& rng, uint64_t seed, RandomStream which)
+{
+    rng = TCODRandom(tcod_seed(split_seed(seed, (uint64_t)which)));
+}
+
+RandomService::RandomService()
+{
+    std::random_device device;
+    seed = ((uint64_t)device() << 32) | device();
+    reseed();
+}
+
+void RandomService::set_seed(uint64_t seed)
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    this->seed = seed;
+    level_started = false;
+    reseed();
+}
+
+uint64_t RandomService::get_seed() const
+{
+    return seed;
+}
+
+uint64_t RandomService::begin_level()
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    seed = peek_next_seed();
+    level_started = true;
+    reseed();
+    return seed;
+}
+
+uint64_t RandomService::peek_next_seed() const
+{
+    return level_started ? split_seed(seed, (uint64_t)RandomStream::COUNT) : seed;
+}
+
+TCODRandom* RandomService::stream(RandomStream which)
+{
+    return &streams[(int)which];
+}
+
+TCODRandom* RandomService::substream(RandomStream which, uint64_t key)
+{
+    const auto child = split_seed(split_seed(seed, (uint64_t)which), key);
+
+    std::lock_guard<std::mutex> guard(lock);
+
+    auto& rng = substreams[child];
+    if (!rng)
+    {
+        rng.reset(new TCODRandom(tcod_seed(child)));
+    }
+
+    return rng.get();
+}
+
+void reseed_stream(SplitMixRandom& rng, uint64_t seed, RandomStream which)
+{
+    rng.reseed(split_seed(seed, (uint64_t)which));
+}
+
+void RandomService::reseed()
+{
+    for (int i = 0; i < (int)RandomStream::COUNT; i++)
+    {
+        reseed_stream(streams[i], seed, (RandomStream)i);
+    }
+
+    substreams.clear();
+}
+
+RandomService& get_random()
+{
+    static RandomService service;
+    return service;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <libtcod/libtcod.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+// one independent stream per pipeline stage, so stages draw the same numbers no matter
+// what ran before them (or next to them, on another thread)
+enum class RandomStream : uint8_t
+{
+    Level,
+    Regions,
+    Population,
+    Plot,
+    World,
+    Player,
+    AI,
+    Commands,
+    Render,
+    COUNT,
+};
+
+// splitmix64 step: derives an uncorrelated child seed for (seed, salt)
+uint64_t split_seed(uint64_t seed, uint64_t salt);
+
+// splitmix64 as a generator, with the getInt/getFloat calls of TCODRandom. its whole state is
+// one word, so unlike a TCODRandom it is reseeded in place without allocating; generation uses it.
+struct SplitMixRandom
+{
+    void reseed(uint64_t seed) { state = seed; }
+
+    uint64_t next();
+
+    // both ends included, like TCODRandom
+    int getInt(int min, int max);
+    float getFloat(float min, float max);
+
+    // like TCODRandom's: a normal around mean that reaches the farther end at three
+    // deviations, clamped to [min, max]
+    float getFloat(float min, float max, float mean);
+
+private:
+    uint64_t state = 0;
+};
+
+// points rng at the stream a level with this seed uses for the given stage, for work that owns
+// its streams. libtcod has no way to seed an existing TCODRandom, so its state is swapped for a
+// freshly seeded one, which libtcod callocs; a SplitMixRandom is reseeded in place.
+void reseed_stream(TCODRandom& rng, uint64_t seed, RandomStream which);
+void reseed_stream(SplitMixRandom& rng, uint64_t seed, RandomStream which);
+
+struct RandomService
+{
+    RandomService();
+
+    // the next begin_level() uses exactly this seed
+    void set_seed(uint64_t seed);
+    uint64_t get_seed() const;
+
+    // reseeds every stream for a new level and returns its seed; the first level uses
+    // the given seed, each later one (F3) steps deterministically from the last
+    uint64_t begin_level();
+
+    // the seed the next begin_level() will return
+    uint64_t peek_next_seed() const;
+
+    TCODRandom* stream(RandomStream which);
+
+    // a child of a stage stream for one region, actor etc.; the same key always gets the same sequence
+    TCODRandom* substream(RandomStream which, uint64_t key);
+
+private:
+    uint64_t seed;
+    bool level_started = false;
+
+    TCODRandom streams[(int)RandomStream::COUNT];
+    std::unordered_map<uint64_t, std::unique_ptr<TCODRandom>> substreams;
+    std::mutex lock;
+
+    void reseed();
+};
+
+RandomService& get_random();
@@ -0,0 +1,97 @@
+#include "sampling.h"
+
+#include <algorithm>
+#include <cmath>
+
+template<typename Random>
+void PoissonDiskSampler::sample(const std::vector<WorldPosition>& candidates, int min_distance, Random* rng, std::vector<WorldPosition>& out, int limit)
+{
+    out.clear();
+    const int count = (int)candidates.size();
+    if (count == 0 || limit == 0) return;
+
+    // a spacing under one tile would let a tile be picked twice
+    min_distance = std::max(1, min_distance);
+
+    int min_x = candidates[0].x, max_x = candidates[0].x;
+    int min_y = candidates[0].y, max_y = candidates[0].y;
+    for (const auto& tile : candidates)
+    {
+        min_x = std::min(min_x, tile.x);
+        max_x = std::max(max_x, tile.x);
+        min_y = std::min(min_y, tile.y);
+        max_y = std::max(max_y, tile.y);
+    }
+
+    // two tiles sharing a cell are less than min_distance apart, so a cell holds one pick at most
+    const int cell = std::max(1, (int)(min_distance / std::sqrt(2.0f)));
+    const int reach = (min_distance + cell - 1) / cell;
+    const int cells_x = (max_x - min_x) / cell + 1;
+    const int cells_y = (max_y - min_y) / cell + 1;
+    const int spacing = min_distance * min_distance;
+
+    cells.assign((size_t)cells_x * cells_y, -1);
+
+    // fisher-yates over indices, so the candidates stay as they are
+    order.resize(count);
+    for (int i = 0; i < count; i++) order[i] = i;
+    for (int i = count - 1; i > 0; i--) std::swap(order[i], order[rng->getInt(0, i)]);
+
+    for (const int i : order)
+    {
+        const auto& tile = candidates[i];
+        const int cx = (tile.x - min_x) / cell;
+        const int cy = (tile.y - min_y) / cell;
+
+        bool okay = true;
+        for (int y = std::max(0, cy - reach); okay && y <= std::min(cells_y - 1, cy + reach); y++)
+        {
+            for (int x = std::max(0, cx - reach); x <= std::min(cells_x - 1, cx + reach); x++)
+            {
+                const int pick = cells[(size_t)y * cells_x + x];
+                if (pick < 0) continue;
+
+                const int dx = out[pick].x - tile.x;
+                const int dy = out[pick].y - tile.y;
+                if (dx * dx + dy * dy < spacing)
+                {
+                    okay = false;
+                    break;
+                }
+            }
+        }
+
+        if (!okay) continue;
+
+        cells[(size_t)cy * cells_x + cx] = (int)out.size();
+        out.push_back(tile);
+        if ((int)out.size() == limit) return;
+    }
+}
+
+template void PoissonDiskSampler::sample(const std::vector<WorldPosition>&, int, TCODRandom*, std::vector<WorldPosition>&, int);
+template void PoissonDiskSampler::sample(const std::vector<WorldPosition>&, int, SplitMixRandom*, std::vector<WorldPosition>&, int);
+
+void TileSet::assign(const std::vector<WorldPosition>& tiles)
+{
+    mask.clear();
+    min_x = min_y = 0;
+    max_x = max_y = -1;
+    if (tiles.empty()) return;
+
+    min_x = max_x = tiles[0].x;
+    min_y = max_y = tiles[0].y;
+    for (const auto& tile : tiles)
+    {
+        min_x = std::min(min_x, tile.x);
+        max_x = std::max(max_x, tile.x);
+        min_y = std::min(min_y, tile.y);
+        max_y = std::max(max_y, tile.y);
+    }
+
+    mask.assign((size_t)(max_x - min_x + 1) * (max_y - min_y + 1), 0);
+    for (const auto& tile : tiles)
+    {
+        mask[(size_t)(tile.y - min_y) * (max_x - min_x + 1) + (tile.x - min_x)] = 1;
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common.h"
+
+// blue-noise picks from an arbitrary set of tiles: candidates are visited once in random order and
+// kept when no earlier pick lies closer than min_distance. a background grid with cells of
+// min_distance / sqrt(2) holds at most one pick each, so every test looks at a fixed handful of
+// cells and a call is linear in the candidates. it always terminates; if the set can't hold
+// `limit` picks at that spacing, fewer come back. buffers are kept between calls.
+struct PoissonDiskSampler
+{
+    // clears `out`, then fills it with at most `limit` picks (all that fit when limit < 0).
+    // built for TCODRandom and SplitMixRandom
+    template<typename Random>
+    void sample(const std::vector<WorldPosition>& candidates, int min_distance, Random* rng, std::vector<WorldPosition>& out, int limit = -1);
+
+private:
+    std::vector<int> order;
+    std::vector<int> cells;
+};
+
+// a tile set as a bitmask over its bounding box, for constant-time membership tests
+struct TileSet
+{
+    int min_x = 0;
+    int min_y = 0;
+    int max_x = -1;
+    int max_y = -1;
+
+    void assign(const std::vector<WorldPosition>& tiles);
+
+    bool contains(WorldPosition tile) const
+    {
+        if (tile.x < min_x || tile.y < min_y || tile.x > max_x || tile.y > max_y) return false;
+        return mask[(size_t)(tile.y - min_y) * (max_x - min_x + 1) + (tile.x - min_x)] != 0;
+    }
+
+private:
+    std::vector<uint8_t> mask;
+};
@@ -0,0 +1,424 @@
+#include "snapshot.h"
+
+#include "level.h"
+#include "random.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    constexpr uint32_t SNAPSHOT_MAGIC = 0x564c5250u; // "PRLV"
+    constexpr uint32_t SNAPSHOT_VERSION = 1;
+
+    struct SnapshotHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        int32_t width;
+        int32_t height;
+        uint64_t seed;
+
+        // the tile untouched cells hold, so loading can leave their chunks unallocated
+        float hue;
+        float sat;
+        float val;
+        char dig;
+        char memory;
+        char region;
+        char pad;
+
+        int32_t room_count;
+        int32_t region_count;
+        int32_t reserved;
+    };
+
+    static_assert(sizeof(SnapshotHeader) == 56, "the header is written as is");
+
+    // positions go to disk as 16-bit pairs, like XY
+    struct PackedPosition
+    {
+        int16_t x;
+        int16_t y;
+    };
+
+    // layout after the header:
+    //   hue, sat, val planes (float), dig, memory, region planes (char), row-major
+    //   walkable bits, then transparent bits, 64 cells a word
+    //   tiles_in_room (int32 x room_count), then per room: count (uint32) and positions
+    //   walkable: count and positions
+    //   per region: centre, count and positions
+
+    struct Writer
+    {
+        std::vector<char> bytes;
+
+        void put(const void* data, size_t size)
+        {
+            const char* from = (const char*)data;
+            bytes.insert(bytes.end(), from, from + size);
+        }
+
+        template<typename T>
+        void put(const T& value)
+        {
+            put(&value, sizeof(T));
+        }
+
+        void put_positions(const std::vector<WorldPosition>& positions)
+        {
+            put((uint32_t)positions.size());
+            for (const auto& pos : positions) put(PackedPosition{ (int16_t)pos.x, (int16_t)pos.y });
+        }
+    };
+
+    // every read is checked against the end of the file; a short file fails instead of overrunning
+    struct Reader
+    {
+        const char* at;
+        const char* end;
+
+        // positions outside of this are rejected
+        int width = 0;
+        int height = 0;
+
+        const char* take(size_t size)
+        {
+            if ((size_t)(end - at) < size) return nullptr;
+            const char* from = at;
+            at += size;
+            return from;
+        }
+
+        template<typename T>
+        bool get(T& value)
+        {
+            const char* from = take(sizeof(T));
+            if (from == nullptr) return false;
+            memcpy(&value, from, sizeof(T));
+            return true;
+        }
+
+        struct Positions
+        {
+            const char* data = nullptr;
+            uint32_t count = 0;
+        };
+
+        bool get_positions(Positions& positions)
+        {
+            if (!get(positions.count)) return false;
+            positions.data = take((size_t)positions.count * sizeof(PackedPosition));
+            if (positions.data == nullptr) return false;
+
+            for (uint32_t i = 0; i < positions.count; i++)
+            {
+                PackedPosition pos;
+                memcpy(&pos, positions.data + i * sizeof(PackedPosition), sizeof(PackedPosition));
+                if (pos.x < 0 || pos.y < 0 || pos.x >= width || pos.y >= height) return false;
+            }
+
+            return true;
+        }
+    };
+
+    void copy_positions(const Reader::Positions& from, std::vector<WorldPosition>& to)
+    {
+        to.resize(from.count);
+        for (uint32_t i = 0; i < from.count; i++)
+        {
+            PackedPosition pos;
+            memcpy(&pos, from.data + i * sizeof(PackedPosition), sizeof(PackedPosition));
+            to[i] = WorldPosition{ pos.x, pos.y };
+        }
+    }
+
+    // a read-only view of a whole file, unmapped when it goes out of scope
+    struct MappedFile
+    {
+        const char* data = nullptr;
+        size_t size = 0;
+
+        bool open(const char* path);
+        ~MappedFile();
+
+#ifdef _WIN32
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = nullptr;
+#endif
+    };
+
+#ifdef _WIN32
+    bool MappedFile::open(const char* path)
+    {
+        file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) return false;
+
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr) return false;
+
+        data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        size = (size_t)file_size.QuadPart;
+        return data != nullptr;
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (data) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+    }
+#else
+    bool MappedFile::open(const char* path)
+    {
+        const int fd = ::open(path, O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0)
+        {
+            close(fd);
+            return false;
+        }
+
+        void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (view == MAP_FAILED) return false;
+
+        data = (const char*)view;
+        size = (size_t)info.st_size;
+        return true;
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (data) munmap((void*)data, size);
+    }
+#endif
+}
+
+bool save_level_snapshot(const Level& level, const char* path)
+{
+    const int width = level.width;
+    const int height = level.height;
+    const size_t cells = (size_t)width * height;
+    const Tile& background = level.terrain.get_background();
+
+    Writer out;
+    out.bytes.reserve(sizeof(SnapshotHeader) + cells * 16);
+
+    SnapshotHeader header{};
+    header.magic = SNAPSHOT_MAGIC;
+    header.version = SNAPSHOT_VERSION;
+    header.width = width;
+    header.height = height;
+    header.seed = level.seed;
+    header.hue = background.hue;
+    header.sat = background.sat;
+    header.val = background.val;
+    header.dig = background.dig;
+    header.memory = background.memory;
+    header.region = background.region;
+    header.room_count = level.room_limit;
+    header.region_count = REGION_COUNT;
+    out.put(header);
+
+    // plane by plane, read through peek() so packed chunks stay packed
+    for (int j = 0; j < height; j++) for (int i = 0; i < width; i++) out.put(level.peek(i, j).hue);
+    for (int j = 0; j < height; j++) for (int i = 0; i < width; i++) out.put(level.peek(i, j).sat);
+    for (int j = 0; j < height; j++) for (int i = 0; i < width; i++) out.put(level.peek(i, j).val);
+    for (int j = 0; j < height; j++) for (int i = 0; i < width; i++) out.put(level.peek(i, j).dig);
+    for (int j = 0; j < height; j++) for (int i = 0; i < width; i++) out.put(level.peek(i, j).memory);
+    for (int j = 0; j < height; j++) for (int i = 0; i < width; i++) out.put(level.peek(i, j).region);
+
+    // the opacity bits as they stand, runtime edits and blocking furniture included
+    const size_t words = (cells + 63) / 64;
+    std::vector<uint64_t> walk(words, 0);
+    std::vector<uint64_t> see(words, 0);
+    for (int j = 0; j < height; j++)
+    {
+        for (int i = 0; i < width; i++)
+        {
+            const size_t cell = (size_t)j * width + i;
+            const bool walkable = level.is_walkable(i, j);
+            const bool transparent = level.is_transparent(i, j);
+
+            if (walkable) walk[cell / 64] |= 1ull << (cell % 64);
+            if (transparent) see[cell / 64] |= 1ull << (cell % 64);
+        }
+    }
+    out.put(walk.data(), words * sizeof(uint64_t));
+    out.put(see.data(), words * sizeof(uint64_t));
+
+    for (int r = 0; r < level.room_limit; r++) out.put((int32_t)level.tiles_in_room[r]);
+    for (int r = 0; r < level.room_limit; r++) out.put_positions(level.tiles[r]);
+
+    out.put_positions(level.walkable);
+
+    for (int r = 0; r < REGION_COUNT; r++)
+    {
+        const auto center = r < (int)level.region_centers.size() ? level.region_centers[r] : WorldPosition{ 0, 0 };
+        out.put(PackedPosition{ (int16_t)center.x, (int16_t)center.y });
+        out.put_positions(level.region_tiles[r]);
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr) return false;
+
+    const bool written = fwrite(out.bytes.data(), 1, out.bytes.size(), file) == out.bytes.size();
+    return fclose(file) == 0 && written;
+}
+
+bool load_level_snapshot(Level& level, const char* path)
+{
+    MappedFile file;
+    if (!file.open(path)) return false;
+
+    Reader in{ file.data, file.data + file.size };
+
+    SnapshotHeader header;
+    if (!in.get(header)) return false;
+    if (header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION) return false;
+    if (header.width <= 0 || header.height <= 0 || header.width > INT16_MAX || header.height > INT16_MAX) return false;
+    if (header.room_count <= 0 || header.region_count != REGION_COUNT) return false;
+
+    const int width = header.width;
+    const int height = header.height;
+    in.width = width;
+    in.height = height;
+    const size_t cells = (size_t)width * height;
+    const size_t words = (cells + 63) / 64;
+
+    // find every section before touching the level, so a bad file changes nothing
+    const char* hue = in.take(cells * sizeof(float));
+    const char* sat = in.take(cells * sizeof(float));
+    const char* val = in.take(cells * sizeof(float));
+    const char* dig = in.take(cells);
+    const char* memory = in.take(cells);
+    const char* region = in.take(cells);
+    const char* walk = in.take(words * sizeof(uint64_t));
+    const char* see = in.take(words * sizeof(uint64_t));
+    const char* room_sizes = in.take((size_t)header.room_count * sizeof(int32_t));
+    if (!hue || !sat || !val || !dig || !memory || !region || !walk || !see || !room_sizes) return false;
+
+    // Level::fill indexes region_tiles by the region byte, so anything else is a corrupt file
+    auto valid_region = [](char value) { return value == ' ' || (value >= '1' && value < '1' + REGION_COUNT); };
+    if (!valid_region(header.region)) return false;
+    for (size_t cell = 0; cell < cells; cell++)
+    {
+        if (!valid_region(region[cell])) return false;
+    }
+
+    std::vector<Reader::Positions> rooms(header.room_count);
+    for (int r = 0; r < header.room_count; r++)
+    {
+        if (!in.get_positions(rooms[r])) return false;
+
+        // a room's count is the length of its list, and never negative
+        int32_t size;
+        memcpy(&size, room_sizes + r * sizeof(int32_t), sizeof(int32_t));
+        if (size < 0 || (uint32_t)size != rooms[r].count) return false;
+    }
+
+    Reader::Positions walkable;
+    if (!in.get_positions(walkable)) return false;
+
+    PackedPosition centers[REGION_COUNT];
+    Reader::Positions regions[REGION_COUNT];
+    for (int r = 0; r < REGION_COUNT; r++)
+    {
+        if (!in.get(centers[r]) || !in.get_positions(regions[r])) return false;
+        if (centers[r].x < 0 || centers[r].y < 0 || centers[r].x >= width || centers[r].y >= height) return false;
+    }
+
+    level.width = width;
+    level.height = height;
+    level.seed = header.seed;
+    reseed_stream(level.terrain_rng, header.seed, RandomStream::Level);
+    reseed_stream(level.region_rng, header.seed, RandomStream::Regions);
+
+    Tile background;
+    background.hue = header.hue;
+    background.sat = header.sat;
+    background.val = header.val;
+    background.dig = header.dig;
+    background.memory = header.memory;
+    background.region = header.region;
+    level.terrain.resize(width, height, background);
+    level.chunk_keep.assign(level.terrain.get_chunk_count(), true);
+    level.residency_version = next_residency_version();
+
+    // cells that still match the background are left alone, so their chunks never allocate
+    for (int j = 0; j < height; j++)
+    {
+        for (int i = 0; i < width; i++)
+        {
+            const size_t cell = (size_t)j * width + i;
+
+            Tile tile;
+            memcpy(&tile.hue, hue + cell * sizeof(float), sizeof(float));
+            memcpy(&tile.sat, sat + cell * sizeof(float), sizeof(float));
+            memcpy(&tile.val, val + cell * sizeof(float), sizeof(float));
+            tile.dig = dig[cell];
+            tile.memory = memory[cell];
+            tile.region = region[cell];
+
+            if (!(tile == background)) level.tile(i, j) = tile;
+        }
+    }
+
+    level.opacity.resize(width, height, 0);
+
+    for (int j = 0; j < height; j++)
+    {
+        for (int i = 0; i < width; i++)
+        {
+            const size_t cell = (size_t)j * width + i;
+            uint64_t walk_word, see_word;
+            memcpy(&walk_word, walk + (cell / 64) * sizeof(uint64_t), sizeof(uint64_t));
+            memcpy(&see_word, see + (cell / 64) * sizeof(uint64_t), sizeof(uint64_t));
+
+            const uint64_t bit = 1ull << (cell % 64);
+            level.set_properties(i, j, (see_word & bit) != 0, (walk_word & bit) != 0);
+        }
+    }
+
+    level.room_limit = header.room_count;
+    level.tiles_in_room.resize(header.room_count);
+    level.tiles.resize(header.room_count);
+    for (int r = 0; r < header.room_count; r++)
+    {
+        int32_t size;
+        memcpy(&size, room_sizes + r * sizeof(int32_t), sizeof(int32_t));
+        level.tiles_in_room[r] = size;
+        copy_positions(rooms[r], level.tiles[r]);
+    }
+
+    copy_positions(walkable, level.walkable);
+
+    level.region_centers.clear();
+    for (int r = 0; r < REGION_COUNT; r++)
+    {
+        level.region_centers.push_back(WorldPosition{ centers[r].x, centers[r].y });
+        copy_positions(regions[r], level.region_tiles[r]);
+    }
+
+    level.link_tiles();
+    return true;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+struct Level;
+
+// a generated level as one binary file: the tile planes, the walk/see bits the fov map is built
+// from, rooms, walkable tiles, and region centres and tiles. loading maps the file and copies it
+// straight into the level, so a saved level starts without running the generator.
+// files are in the writing machine's byte order; one from the other order fails the magic check.
+bool save_level_snapshot(const Level& level, const char* path);
+
+// false if the file is missing, from another version or cut short; the level is then left as it was
+bool load_level_snapshot(Level& level, const char* path);
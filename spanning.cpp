@@ -0,0 +1,140 @@
+#include "spanning.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+static float squared_distance(const WorldPosition& a, const WorldPosition& b)
+{
+    const float dx = (float)(a.x - b.x);
+    const float dy = (float)(a.y - b.y);
+    return dx * dx + dy * dy;
+}
+
+std::vector<SpanningEdge> geometric_spanning_tree(const std::vector<WorldPosition>& points, int neighbours)
+{
+    SpanningTreeBuilder builder;
+    return builder.build(points, neighbours);
+}
+
+const std::vector<SpanningEdge>& SpanningTreeBuilder::build(const std::vector<WorldPosition>& points, int neighbours)
+{
+    tree.clear();
+    const int count = (int)points.size();
+    if (count < 2) return tree;
+
+    int min_x = points[0].x, max_x = points[0].x;
+    int min_y = points[0].y, max_y = points[0].y;
+    for (const auto& point : points)
+    {
+        min_x = std::min(min_x, point.x);
+        max_x = std::max(max_x, point.x);
+        min_y = std::min(min_y, point.y);
+        max_y = std::max(max_y, point.y);
+    }
+
+    // about one point per bucket
+    const int span_x = max_x - min_x + 1;
+    const int span_y = max_y - min_y + 1;
+    const int cell = std::max(1, (int)std::sqrt((float)span_x * span_y / count));
+    const int buckets_x = span_x / cell + 1;
+    const int buckets_y = span_y / cell + 1;
+
+    bucket_start.assign(buckets_x * buckets_y + 1, 0);
+    bucketed.resize(count);
+
+    const auto bucket_of = [&](const WorldPosition& point) {
+        return ((point.x - min_x) / cell) * buckets_y + (point.y - min_y) / cell;
+    };
+
+    for (const auto& point : points) bucket_start[bucket_of(point) + 1]++;
+    for (size_t i = 1; i < bucket_start.size(); i++) bucket_start[i] += bucket_start[i - 1];
+    bucket_fill.assign(bucket_start.begin(), bucket_start.end());
+    for (int i = 0; i < count; i++) bucketed[bucket_fill[bucket_of(points[i])]++] = i;
+
+    candidates.clear();
+    const int wanted = std::min(neighbours, count - 1);
+
+    for (int i = 0; i < count; i++)
+    {
+        const int bx = (points[i].x - min_x) / cell;
+        const int by = (points[i].y - min_y) / cell;
+        nearest.clear();
+
+        // grow square rings of buckets until nothing outside the ring can beat the current k-th best
+        for (int ring = 0; ring <= std::max(buckets_x, buckets_y); ring++)
+        {
+            for (int x = bx - ring; x <= bx + ring; x++)
+            {
+                if (x < 0 || x >= buckets_x) continue;
+
+                for (int y = by - ring; y <= by + ring; y++)
+                {
+                    if (y < 0 || y >= buckets_y) continue;
+                    if (std::max(std::abs(x - bx), std::abs(y - by)) != ring) continue;
+
+                    const int bucket = x * buckets_y + y;
+                    for (int k = bucket_start[bucket]; k < bucket_start[bucket + 1]; k++)
+                    {
+                        const int j = bucketed[k];
+                        if (j != i) nearest.push_back({ squared_distance(points[i], points[j]), j });
+                    }
+                }
+            }
+
+            if ((int)nearest.size() >= wanted)
+            {
+                std::nth_element(nearest.begin(), nearest.begin() + (wanted - 1), nearest.end());
+                const float reach = (float)(ring * cell);
+                if (nearest[wanted - 1].first <= reach * reach) break;
+            }
+        }
+
+        std::partial_sort(nearest.begin(), nearest.begin() + std::min(wanted, (int)nearest.size()), nearest.end());
+        for (int k = 0; k < wanted && k < (int)nearest.size(); k++)
+        {
+            const int j = nearest[k].second;
+            candidates.push_back(SpanningEdge{ std::min(i, j), std::max(i, j), nearest[k].first });
+        }
+    }
+
+    // kruskal; ties break on the endpoints so equal-length layouts always give the same tree
+    std::sort(candidates.begin(), candidates.end(), [](const SpanningEdge& l, const SpanningEdge& r) {
+        if (l.weight != r.weight) return l.weight < r.weight;
+        return l.a != r.a ? l.a < r.a : l.b < r.b;
+    });
+
+    sets.reset(count);
+
+    for (const auto& edge : candidates)
+    {
+        if (sets.unite(edge.a, edge.b))
+        {
+            tree.push_back(edge);
+            if ((int)tree.size() == count - 1) return tree;
+        }
+    }
+
+    // rare: clusters further apart than any point's nearest neighbours
+    while ((int)tree.size() < count - 1)
+    {
+        SpanningEdge best{ -1, -1, std::numeric_limits<float>::max() };
+        for (int i = 0; i < count; i++)
+        {
+            if (sets.find(i) != sets.find(0)) continue;
+
+            for (int j = 0; j < count; j++)
+            {
+                if (sets.find(j) == sets.find(0)) continue;
+
+                const float weight = squared_distance(points[i], points[j]);
+                if (weight < best.weight) best = SpanningEdge{ i, j, weight };
+            }
+        }
+
+        sets.unite(best.a, best.b);
+        tree.push_back(best);
+    }
+
+    return tree;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+
+#include "common.h"
+#include "labelling.h"
+
+struct SpanningEdge
+{
+    int a;
+    int b;
+    float weight;
+};
+
+// euclidean spanning tree over a point array. candidate edges come from each point's
+// `neighbours` nearest points (found through grid buckets), so the cost stays near n log n
+// instead of n^2. that is the exact minimum whenever every tree edge is among the candidates,
+// and only a little longer when dense clumps crowd them out; if the candidates leave the tree
+// in pieces, the closest pair across pieces is added until it is whole. weights are squared distances.
+std::vector<SpanningEdge> geometric_spanning_tree(const std::vector<WorldPosition>& points, int neighbours = 8);
+
+// the same tree, built in buffers kept between calls; the result is valid until the next build
+struct SpanningTreeBuilder
+{
+    const std::vector<SpanningEdge>& build(const std::vector<WorldPosition>& points, int neighbours = 8);
+
+private:
+    std::vector<SpanningEdge> tree;
+    std::vector<SpanningEdge> candidates;
+    std::vector<std::pair<float, int>> nearest;
+    std::vector<int> bucket_start;
+    std::vector<int> bucket_fill;
+    std::vector<int> bucketed;
+    DisjointSets sets;
+};
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "common.h"
+#include "grid.h"
+
+// one row of a stamp: cells [x0, x1) of row y
+struct StampSpan
+{
+    int y;
+    int x0;
+    int x1;
+};
+
+// a shape cut into row spans, clipped once when it is built. the kernels below then run over
+// plain contiguous runs of a row-major grid with no per-cell bounds checks or branches, which
+// the compiler turns into vector code. spans are kept between shapes, so stamping allocates nothing.
+struct Stamp
+{
+    std::vector<StampSpan> spans;
+    // cells covered by all spans; per-cell value arrays are laid out span by span
+    int count = 0;
+
+    // only cells in [min_x, max_x) x [min_y, max_y) are stamped from now on
+    void clip(int min_x, int min_y, int max_x, int max_y)
+    {
+        this->min_x = min_x;
+        this->min_y = min_y;
+        this->max_x = max_x;
+        this->max_y = max_y;
+    }
+
+    // cells [x0, x1) x [y0, y1)
+    Stamp& rect(int x0, int y0, int x1, int y1)
+    {
+        reset();
+        for (int y = y0; y < y1; y++) add(y, x0, x1);
+        return *this;
+    }
+
+    // cells no further than radius from (cx, cy)
+    Stamp& disc(int cx, int cy, int radius)
+    {
+        reset();
+
+        int half = radius;
+        for (int dy = 0; dy <= radius; dy++)
+        {
+            // widest run along this row; shrinks as the rows move away from the centre
+            while (half * half + dy * dy > radius * radius) half--;
+
+            add(cy - dy, cx - half, cx + half + 1);
+            if (dy > 0) add(cy + dy, cx - half, cx + half + 1);
+        }
+
+        return *this;
+    }
+
+private:
+    int min_x = 0;
+    int min_y = 0;
+    int max_x = 0;
+    int max_y = 0;
+
+    void reset()
+    {
+        spans.clear();
+        count = 0;
+    }
+
+    void add(int y, int x0, int x1)
+    {
+        if (y < min_y || y >= max_y) return;
+
+        x0 = std::max(x0, min_x);
+        x1 = std::min(x1, max_x);
+        if (x0 >= x1) return;
+
+        spans.push_back(StampSpan{ y, x0, x1 });
+        count += x1 - x0;
+    }
+};
+
+namespace stamp
+{
+    // calls op(cells, n, first) on each span's run of cells; first is the span's offset into per-cell arrays
+    template<typename T, typename Op>
+    inline void each_run(Grid<T>& grid, const Stamp& shape, Op op)
+    {
+        int first = 0;
+        for (const auto& span : shape.spans)
+        {
+            const int n = span.x1 - span.x0;
+            op(grid.row(span.y) + span.x0, n, first);
+            first += n;
+        }
+    }
+
+    inline void multiply(Grid<float>& grid, const Stamp& shape, float factor)
+    {
+        each_run(grid, shape, [factor](float* cells, int n, int) {
+            for (int i = 0; i < n; i++) cells[i] *= factor;
+        });
+    }
+
+    inline void set(Grid<float>& grid, const Stamp& shape, float value)
+    {
+        each_run(grid, shape, [value](float* cells, int n, int) {
+            for (int i = 0; i < n; i++) cells[i] = value;
+        });
+    }
+
+    // moves each cell weight of the way towards value; stacks noise layers on top of each other
+    inline void blend(Grid<float>& grid, const Stamp& shape, float value, float weight)
+    {
+        each_run(grid, shape, [value, weight](float* cells, int n, int) {
+            for (int i = 0; i < n; i++) cells[i] += (value - cells[i]) * weight;
+        });
+    }
+
+    // per-cell versions: values holds shape.count entries, in span order
+    inline void multiply(Grid<float>& grid, const Stamp& shape, const float* factors)
+    {
+        each_run(grid, shape, [factors](float* cells, int n, int first) {
+            for (int i = 0; i < n; i++) cells[i] *= factors[first + i];
+        });
+    }
+
+    inline void set(Grid<float>& grid, const Stamp& shape, const float* values)
+    {
+        each_run(grid, shape, [values](float* cells, int n, int first) {
+            for (int i = 0; i < n; i++) cells[i] = values[first + i];
+        });
+    }
+
+    // takes values only where the cell's roll is at least threshold, a select rather than a branch
+    inline void set_where(Grid<float>& grid, const Stamp& shape, const float* values, const float* rolls, float threshold)
+    {
+        each_run(grid, shape, [values, rolls, threshold](float* cells, int n, int first) {
+            for (int i = 0; i < n; i++) cells[i] = rolls[first + i] >= threshold ? values[first + i] : cells[i];
+        });
+    }
+
+    // one uniform draw per stamped cell in a single tight loop, ready for the per-cell kernels
+    template<typename Random>
+    inline void random(Random* rng, const Stamp& shape, std::vector<float>& out, float min, float max)
+    {
+        out.resize(shape.count);
+        for (int i = 0; i < shape.count; i++) out[i] = rng->getFloat(min, max);
+    }
+}
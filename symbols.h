@@ -3,6 +3,7 @@
 #include "common.h"
 #include "engine.h"
 #include "level.h"
+#include "palette.h"
 
 struct BlockMovementThroughPeopleSystem
     : public OneOffSystem
@@ -81,87 +82,94 @@ struct BlockMovementThroughPeopleSystem
 struct SymbolRenderSystem
     : public RuntimeSystem
     , public AccessWorld_UseUnique<Level>
-    , public AccessWorld_UseUnique<PlayerFOV>
-    , public AccessWorld_QueryAllEntitiesWith<Symbol, WorldPosition>
-    , public AccessWorld_QueryAllEntitiesWith<Person, Symbol, WorldPosition>
-    , public AccessWorld_QueryAllEntitiesWith<Player, Symbol, WorldPosition>
-    , public AccessWorld_QueryComponent<Health>
-    , public AccessWorld_QueryComponent<Person>
-    , public AccessWorld_QueryComponent<Player>
-    , public AccessWorld_QueryComponent<Colored>
+    , public AccessWorld_UseUnique<const PlayerFOV>
+    , public AccessWorld_UseUnique<const Camera>
+    , public AccessWorld_QueryAllEntitiesWith<const Symbol, const WorldPosition>
+    , public AccessWorld_QueryAllEntitiesWith<const Person, const Symbol, const WorldPosition>
+    , public AccessWorld_QueryAllEntitiesWith<const Player, const Symbol, const WorldPosition>
+    , public AccessWorld_QueryComponent<const Health>
+    , public AccessWorld_QueryComponent<const Person>
+    , public AccessWorld_QueryComponent<const Player>
+    , public AccessWorld_QueryComponent<const Colored>
     , public AccessConsole
 {
+    static constexpr RGB DEFAULT_COLOR = "#ffffff"_rgb;
+    static constexpr float FOG_LIGHTNESS = 0.15f;
+
+    // remembered symbols out of sight, looked up rather than converted
+    HSLTable fog;
+
     void activate() override
     {
         auto& level = AccessWorld_UseUnique<Level>::access_unique();
-        auto& fov = AccessWorld_UseUnique<PlayerFOV>::access_unique();
+        auto& fov = AccessWorld_UseUnique<const PlayerFOV>::access_unique();
+        const auto& camera = AccessWorld_UseUnique<const Camera>::access_unique();
+
+        fog.build(FOG_LIGHTNESS);
         
-        for (auto&& [entity, symbol, world_pos] : AccessWorld_QueryAllEntitiesWith<Symbol, WorldPosition>::query().each())
+        for (auto&& [entity, symbol, world_pos] : AccessWorld_QueryAllEntitiesWith<const Symbol, const WorldPosition>::query().each())
         {
-            if (AccessWorld_QueryComponent<Person>::has_component(entity)) continue;
-            if (AccessWorld_QueryComponent<Player>::has_component(entity)) continue;
-
-            const ScreenPosition wp = { world_pos.x, world_pos.y };
+            if (AccessWorld_QueryComponent<const Person>::has_component(entity)) continue;
+            if (AccessWorld_QueryComponent<const Player>::has_component(entity)) continue;
 
-            std::string s(1, level.regions[wp.x][wp.y]);
+            if (!camera.in_view(world_pos)) continue;
+            const auto scr = camera.to_screen(world_pos);
             
-            if (fov.fields.count(world_pos) > 0)
+            if (fov.is_visible(world_pos))
             {
-                if (AccessWorld_QueryComponent<Colored>::has_component(entity))
+                if (AccessWorld_QueryComponent<const Colored>::has_component(entity))
                 {
-                    fg(wp, AccessWorld_QueryComponent<Colored>::get_component(entity).color);
+                    fg(scr, AccessWorld_QueryComponent<const Colored>::get_component(entity).color);
                 }
                 else
                 {
-                    fg(wp, "#ffffff"_rgb);
+                    fg(scr, DEFAULT_COLOR);
                 }
-                ch(wp, symbol.sym);
-                level.memory[wp.x][wp.y] = symbol.sym[0];
+                ch(scr, symbol.sym);
+                level.tile(world_pos.x, world_pos.y).memory = symbol.sym[0];
             }
             else
             {
-                fg(wp, HSL(level.hues[wp.x][wp.y], level.sats[wp.x][wp.y], 0.15f));
-                std::string s(1, level.memory[wp.x][wp.y]);
-                ch(wp, s);
+                const auto tile = level.peek(world_pos.x, world_pos.y);
+                put(scr, (unsigned char)tile.memory, fog.at(tile.hue, tile.sat));
             }
         }
 
-        for (auto&& [entity, _, symbol, world_pos] : AccessWorld_QueryAllEntitiesWith<Person, Symbol, WorldPosition>::query().each())
+        for (auto&& [entity, _, symbol, world_pos] : AccessWorld_QueryAllEntitiesWith<const Person, const Symbol, const WorldPosition>::query().each())
         {
-            const ScreenPosition wp = { world_pos.x, world_pos.y };
-
-            std::string s(1, level.regions[wp.x][wp.y]);
+            if (!camera.in_view(world_pos)) continue;
+            const auto scr = camera.to_screen(world_pos);
 
-            if (fov.fields.count(world_pos) > 0)
+            if (fov.is_visible(world_pos))
             {
-                if (AccessWorld_QueryComponent<Colored>::has_component(entity))
+                if (AccessWorld_QueryComponent<const Colored>::has_component(entity))
                 {
-                    fg(wp, AccessWorld_QueryComponent<Colored>::get_component(entity).color);
+                    fg(scr, AccessWorld_QueryComponent<const Colored>::get_component(entity).color);
                 }
                 else
                 {
-                    fg(wp, "#ffffff"_rgb);
+                    fg(scr, DEFAULT_COLOR);
                 }
-                ch(wp, symbol.sym);
-                level.memory[wp.x][wp.y] = symbol.sym[0];
+                ch(scr, symbol.sym);
+                level.tile(world_pos.x, world_pos.y).memory = symbol.sym[0];
             }
         }
 
-        for (auto&& [entity, symbol, world_pos] : AccessWorld_QueryAllEntitiesWith<Player, Symbol, WorldPosition>::query().each())
+        for (auto&& [entity, symbol, world_pos] : AccessWorld_QueryAllEntitiesWith<const Player, const Symbol, const WorldPosition>::query().each())
         {
-            const ScreenPosition wp = { world_pos.x, world_pos.y };
+            if (!camera.in_view(world_pos)) continue;
+            const auto scr = camera.to_screen(world_pos);
 
-            std::string s(1, level.regions[wp.x][wp.y]);
-            if (AccessWorld_QueryComponent<Colored>::has_component(entity))
+            if (AccessWorld_QueryComponent<const Colored>::has_component(entity))
             {
-                fg(wp, AccessWorld_QueryComponent<Colored>::get_component(entity).color);
+                fg(scr, AccessWorld_QueryComponent<const Colored>::get_component(entity).color);
             }
             else
             {
-                fg(wp, "#ffffff"_rgb);
+                fg(scr, DEFAULT_COLOR);
             }
-            ch(wp, symbol.sym);
-            level.memory[wp.x][wp.y] = symbol.sym[0];
+            ch(scr, symbol.sym);
+            level.tile(world_pos.x, world_pos.y).memory = symbol.sym[0];
         }
     }
 };
@@ -16,6 +16,8 @@ void TimeSystem::activate()
 
 void TimeSystem::react_to_event(ActionCompleteSignal& signal)
 {
+	turns_taken++;
+
 	auto& q = AccessWorld_UseUnique<TurnOrderQueue>::access_unique();
 	auto& current_in_order = AccessWorld_UseUnique<CurrentInTurn>::access_unique();
 	auto current_entity = current_in_order.current;
@@ -58,7 +60,8 @@ void TimeSystem::react_to_event(ActionCompleteSignal& signal)
 	current_in_order.current = std::get<2>(top);
 	q.order.pop();
 
-	AccessEvents_Emit<AwaitingActionSignal>::emit_event(AwaitingActionSignal{ current_in_order.current });
+	// queued, so a long NPC round unwinds between turns instead of recursing through every actor
+	AccessEvents_Emit<AwaitingActionSignal>::enqueue_event(AwaitingActionSignal{ current_in_order.current });
 }
 
 void TimeSystem::react_to_event(CalendarUpdateSignal&)
@@ -22,6 +22,9 @@ struct TimeSystem
 {
 	bool pick_next_in_turn_order = false;
 
+	// actions completed since the game started, for the headless throughput line
+	long turns_taken = 0;
+
 	void activate() override;
 	void react_to_event(ActionCompleteSignal& signal) override;
 	void react_to_event(CalendarUpdateSignal&) override;
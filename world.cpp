@@ -14,6 +14,8 @@ void WorldCrafting::execute_crafting()
 
 		auto tiles = level.region_tiles[i];
 		auto center = level.region_centers[i];
+		region_rng = get_random().substream(RandomStream::World, i);
+		region_set.assign(tiles);
 
 		if (name == "WAREHOUSE")
 			create_warehouse(level, people_mapping, i, tiles, center);
@@ -62,7 +64,7 @@ void WorldCrafting::execute_crafting()
 
 Entity WorldCrafting::create_wares(WorldPosition tile, char sym)
 {
-	TCODRandom* rng = TCODRandom::getInstance();
+	TCODRandom* rng = region_rng;
 
 	auto entity = create_entity();
 	std::string s(1, sym);
@@ -82,7 +84,7 @@ Entity WorldCrafting::create_wares(WorldPosition tile, char sym)
 
 Entity WorldCrafting::create_machine(WorldPosition tile)
 {
-	TCODRandom* rng = TCODRandom::getInstance();
+	TCODRandom* rng = region_rng;
 
 	auto entity = create_entity();
 	std::string s(1, MACHINE_SYM);
@@ -102,7 +104,7 @@ Entity WorldCrafting::create_machine(WorldPosition tile)
 
 Entity WorldCrafting::create_bookshelf(WorldPosition tile)
 {
-	TCODRandom* rng = TCODRandom::getInstance();
+	TCODRandom* rng = region_rng;
 
 	auto entity = create_entity();
 	std::string s(1, BOOKCASE_SYM);
@@ -124,7 +126,7 @@ Entity WorldCrafting::create_bookshelf(WorldPosition tile)
 
 Entity WorldCrafting::create_furnace(WorldPosition tile)
 {
-	TCODRandom* rng = TCODRandom::getInstance();
+	TCODRandom* rng = region_rng;
 
 	auto entity = create_entity();
 	std::string s(1, FURNACE_SYM);
@@ -144,7 +146,7 @@ Entity WorldCrafting::create_furnace(WorldPosition tile)
 
 Entity WorldCrafting::create_chest(WorldPosition tile)
 {
-	TCODRandom* rng = TCODRandom::getInstance();
+	TCODRandom* rng = region_rng;
 
 	auto entity = create_entity();
 	std::string s(1, CHEST_SYM);
@@ -179,33 +181,34 @@ Entity WorldCrafting::create_chest(WorldPosition tile)
 void WorldCrafting::block_sight(Entity e, WorldPosition wp)
 {
 	add_tag_component<Blocked>(e);
-	AccessWorld_UseUnique<Level>::access_unique().map->setProperties(wp.x, wp.y, false, true);
+	AccessWorld_UseUnique<Level>::access_unique().set_properties(wp.x, wp.y, false, true);
 }
 
 void WorldCrafting::block_walking(Entity e, WorldPosition wp)
 {
 	add_tag_component<Blocked>(e);
-	AccessWorld_UseUnique<Level>::access_unique().map->setProperties(wp.x, wp.y, true, false);
+	AccessWorld_UseUnique<Level>::access_unique().set_properties(wp.x, wp.y, true, false);
 }
 
 void WorldCrafting::block_sight_walking(Entity e, WorldPosition wp)
 {
 	add_tag_component<Blocked>(e);
-	AccessWorld_UseUnique<Level>::access_unique().map->setProperties(wp.x, wp.y, false, false);
+	AccessWorld_UseUnique<Level>::access_unique().set_properties(wp.x, wp.y, false, false);
 }
 
 void WorldCrafting::create_warehouse(Level& level, PeopleMapping& mapping, int region, std::vector<WorldPosition> tiles, WorldPosition center)
 {
-	TCODRandom* rng = TCODRandom::getInstance();
+	TCODRandom* rng = region_rng;
 
 	static constexpr int sym_size = 2;
 	static char syms[sym_size]{ WIRE_SYM, CHEST_SYM };
 
 	for (auto tile : tiles)
 	{
-		level.dig[tile.x][tile.y] = FLOOR_SYM;
-		level.hues[tile.x][tile.y] = 200.0f;
-		level.sats[tile.x][tile.y] = rng->getFloat(0.1f, 0.25f);
+		auto& cell = level.tile(tile.x, tile.y);
+		cell.dig = FLOOR_SYM;
+		cell.hue = 200.0f;
+		cell.sat = rng->getFloat(0.1f, 0.25f);
 	}
 
 	std::sort(tiles.begin(), tiles.end(), [&](WorldPosition& a, WorldPosition& b) { return a.distance(center) > b.distance(center); });
@@ -229,7 +232,7 @@ void WorldCrafting::create_warehouse(Level& level, PeopleMapping& mapping, int r
 
 void WorldCrafting::create_machine_shop(Level& level, PeopleMapping& mapping, int region, std::vector<WorldPosition> tiles, WorldPosition center)
 {
-	TCODRandom* rng = TCODRandom::getInstance();
+	TCODRandom* rng = region_rng;
 
 	static constexpr int sym_size = 12;
 	static char syms[sym_size]{ WIRE_SYM, WIRE_SYM, WIRE_SYM, MACHINE_SYM, MACHINE_SYM, MACHINE_SYM, MACHINE_SYM, DRILL_SYM, DRILL_SYM, DRILL_SYM, DRILL_SYM, BOOKCASE_SYM };
@@ -238,8 +241,9 @@ void WorldCrafting::create_machine_shop(Level& level, PeopleMapping& mapping, in
 
 	for (auto tile : tiles)
 	{
-		level.hues[tile.x][tile.y] = rng->getFloat(-180.0f, -160.0f);
-		level.sats[tile.x][tile.y] = rng->getFloat(0.25f, 0.75f);
+		auto& cell = level.tile(tile.x, tile.y);
+		cell.hue = rng->getFloat(-180.0f, -160.0f);
+		cell.sat = rng->getFloat(0.25f, 0.75f);
 	}
 
 	for (int i = 0; i < tiles.size() / 2;)
@@ -267,7 +271,7 @@ void WorldCrafting::create_machine_shop(Level& level, PeopleMapping& mapping, in
 
 void WorldCrafting::create_library(Level& level, PeopleMapping& mapping, int region, std::vector<WorldPosition> tiles, WorldPosition center)
 {
-	TCODRandom* rng = TCODRandom::getInstance();
+	TCODRandom* rng = region_rng;
 
 	int min_x = 1000;
 	int min_y = 1000;
@@ -276,14 +280,15 @@ void WorldCrafting::create_library(Level& level, PeopleMapping& mapping, int reg
 
 	for (auto tile : tiles)
 	{
+		auto& cell = level.tile(tile.x, tile.y);
 		if (tile.x < min_x) min_x = tile.x;
 		if (tile.y < min_y) min_y = tile.y;
 		if (tile.x > max_x) max_x = tile.x;
 		if (tile.y > max_y) max_y = tile.y;
 
-		level.dig[tile.x][tile.y] = FLOOR_SYM;
-		level.hues[tile.x][tile.y] = 0.0f;
-		level.sats[tile.x][tile.y] = rng->getFloat(0.4f, 0.75f);
+		cell.dig = FLOOR_SYM;
+		cell.hue = 0.0f;
+		cell.sat = rng->getFloat(0.4f, 0.75f);
 	}
 
 	for (int i = min_x; i <= max_x; i++)
@@ -292,7 +297,7 @@ void WorldCrafting::create_library(Level& level, PeopleMapping& mapping, int reg
 		{
 			auto tile = WorldPosition{ i, j };
 			if (i % 2 == 0) continue;
-			if (std::find(tiles.begin(), tiles.end(), tile) != tiles.end())
+			if (region_set.contains(tile))
 			{
 				if (rng->getInt(0, 100) > 80) continue;
 				create_bookshelf(tile);
@@ -322,30 +327,12 @@ void WorldCrafting::create_mineshaft(Level& level, PeopleMapping& mapping, int r
 
 void WorldCrafting::create_junkyard(Level& level, PeopleMapping& mapping, int region, std::vector<WorldPosition> tiles, WorldPosition center)
 {
-	TCODRandom* rng = TCODRandom::getInstance();
+	TCODRandom* rng = region_rng;
 
-	std::vector<WorldPosition> heaps;
-	shuffle(tiles);
+	// heap centres at least four tiles apart, so no two 3x3 heaps share a tile
+	sampler.sample(tiles, 4, rng, picks);
 
-	for (auto t : tiles)
-	{		
-		bool okay = true;
-		for (auto h : heaps)
-		{
-			if (t.distance(h) <= 3)
-			{
-				okay = false;
-				break;
-			}
-		}
-
-		if (okay)
-		{
-			heaps.push_back(t);			
-		}
-	}
-
-	for (auto h : heaps)
+	for (auto h : picks)
 	{
 		for (int i = -1; i < 2; i++)
 		{
@@ -379,7 +366,7 @@ void WorldCrafting::create_junkyard(Level& level, PeopleMapping& mapping, int re
 
 void WorldCrafting::create_foundry(Level& level, PeopleMapping& mapping, int region, std::vector<WorldPosition> tiles, WorldPosition center)
 {
-	TCODRandom* rng = TCODRandom::getInstance();
+	TCODRandom* rng = region_rng;
 
 	int min_x = 1000;
 	int min_y = 1000;
@@ -388,16 +375,17 @@ void WorldCrafting::create_foundry(Level& level, PeopleMapping& mapping, int reg
 
 	for (auto tile : tiles)
 	{
-		level.hues[tile.x][tile.y] = rng->getFloat(-20.0f, 20.0f);
-		level.sats[tile.x][tile.y] = rng->getFloat(0.9f, 1.0f);
-		level.vals[tile.x][tile.y] = 1.0f;
+		auto& cell = level.tile(tile.x, tile.y);
+		cell.hue = rng->getFloat(-20.0f, 20.0f);
+		cell.sat = rng->getFloat(0.9f, 1.0f);
+		cell.val = 1.0f;
 
 		if (tile.x < min_x) min_x = tile.x;
 		if (tile.y < min_y) min_y = tile.y;
 		if (tile.x > max_x) max_x = tile.x;
 		if (tile.y > max_y) max_y = tile.y;
 
-		level.dig[tile.x][tile.y] = rng->getInt('v', 'y');
+		cell.dig = rng->getInt('v', 'y');
 
 		auto hot_air = create_entity();
 		add_component<WorldPosition>(hot_air);
@@ -411,7 +399,7 @@ void WorldCrafting::create_foundry(Level& level, PeopleMapping& mapping, int reg
 			auto tile = WorldPosition{ i, j };
 			if (i % 3 == 0 && j % 3 == 0)
 			{
-				if (std::find(tiles.begin(), tiles.end(), tile) != tiles.end())
+				if (region_set.contains(tile))
 				{
 					if (rng->getInt(0, 100) > 60) continue;
 					create_furnace(tile);
@@ -423,7 +411,7 @@ void WorldCrafting::create_foundry(Level& level, PeopleMapping& mapping, int reg
 
 void WorldCrafting::create_skyport(Level& level, PeopleMapping& mapping, int region, std::vector<WorldPosition> tiles, WorldPosition center)
 {
-	TCODRandom* rng = TCODRandom::getInstance();
+	TCODRandom* rng = region_rng;
 
 	int min_x = 1000;
 	int min_y = 1000;
@@ -432,9 +420,10 @@ void WorldCrafting::create_skyport(Level& level, PeopleMapping& mapping, int reg
 
 	for (auto tile : tiles)
 	{
-		level.hues[tile.x][tile.y] = rng->getFloat(220.0f, 240.0f);
-		level.sats[tile.x][tile.y] = rng->getFloat(0.0f, 0.1f);
-		level.vals[tile.x][tile.y] = 1.0f;
+		auto& cell = level.tile(tile.x, tile.y);
+		cell.hue = rng->getFloat(220.0f, 240.0f);
+		cell.sat = rng->getFloat(0.0f, 0.1f);
+		cell.val = 1.0f;
 
 		if (tile.x < min_x) min_x = tile.x;
 		if (tile.y < min_y) min_y = tile.y;
@@ -457,7 +446,7 @@ void WorldCrafting::create_skyport(Level& level, PeopleMapping& mapping, int reg
 			auto distance = center.distance(tile);
 
 			if (distance < max_distance / 4) continue;
-			if (std::find(tiles.begin(), tiles.end(), tile) != tiles.end())
+			if (region_set.contains(tile))
 			{
 				if (rng->getFloat(0.0f, 1.0f) > (distance / max_distance))
 				{
@@ -478,7 +467,7 @@ void WorldCrafting::create_lounge(Level& level, PeopleMapping& mapping, int regi
 
 void WorldCrafting::create_market(Level& level, PeopleMapping& mapping, int region, std::vector<WorldPosition> tiles, WorldPosition center)
 {
-	TCODRandom* rng = TCODRandom::getInstance();
+	TCODRandom* rng = region_rng;
 	
 	int min_x = 1000;
 	int min_y = 1000;
@@ -487,14 +476,15 @@ void WorldCrafting::create_market(Level& level, PeopleMapping& mapping, int regi
 
 	for (auto tile : tiles)
 	{
+		auto& cell = level.tile(tile.x, tile.y);
 		if (tile.x < min_x) min_x = tile.x;
 		if (tile.y < min_y) min_y = tile.y;
 		if (tile.x > max_x) max_x = tile.x;
 		if (tile.y > max_y) max_y = tile.y;
 
-		level.dig[tile.x][tile.y] = '.';
-		level.hues[tile.x][tile.y] = rng->getFloat(0.0f, 6.0f) * 60.0f + rng->getFloat(-10.0f, 10.0f);
-		level.sats[tile.x][tile.y] = rng->getFloat(0.4f, 0.75f);
+		cell.dig = '.';
+		cell.hue = rng->getFloat(0.0f, 6.0f) * 60.0f + rng->getFloat(-10.0f, 10.0f);
+		cell.sat = rng->getFloat(0.4f, 0.75f);
 	}
 
 	for (int i = min_x; i <= max_x; i++)
@@ -513,7 +503,7 @@ void WorldCrafting::create_market(Level& level, PeopleMapping& mapping, int regi
 			if ((i + j) % 2 == 0) continue;
 			auto tile = WorldPosition{ i + dx, j + dy };
 			
-			if (std::find(tiles.begin(), tiles.end(), tile) != tiles.end())
+			if (region_set.contains(tile))
 			{
 				auto carpet = create_entity();
 				add_component<WorldPosition>(carpet, tile.x, tile.y);
@@ -542,7 +532,7 @@ void WorldCrafting::create_drinking_hole(Level& level, PeopleMapping& mapping, i
 void WorldCrafting::create_shrine(Level& level, PeopleMapping& mapping, int region, std::vector<WorldPosition> tiles, WorldPosition center)
 {
 	char syms[4]{ 'i', 'j', 'k', 'l' };
-	TCODRandom* rng = TCODRandom::getInstance();
+	TCODRandom* rng = region_rng;
 
 	int min_x = 1000;
 	int min_y = 1000;
@@ -551,9 +541,10 @@ void WorldCrafting::create_shrine(Level& level, PeopleMapping& mapping, int regi
 
 	for (auto tile : tiles)
 	{
-		level.hues[tile.x][tile.y] = rng->getFloat(0.0f, 360.0f);
-		level.sats[tile.x][tile.y] = rng->getFloat(0.0f, 0.3f);
-		level.vals[tile.x][tile.y] = 1.0f;
+		auto& cell = level.tile(tile.x, tile.y);
+		cell.hue = rng->getFloat(0.0f, 360.0f);
+		cell.sat = rng->getFloat(0.0f, 0.3f);
+		cell.val = 1.0f;
 
 		if (tile.x < min_x) min_x = tile.x;
 		if (tile.y < min_y) min_y = tile.y;
@@ -573,7 +564,7 @@ void WorldCrafting::create_shrine(Level& level, PeopleMapping& mapping, int regi
 			if (i % 2 == 0 && (i + j) % 2 == 0)
 			{
 				auto tile = WorldPosition{ i, j };
-				if (std::find(tiles.begin(), tiles.end(), tile) != tiles.end())
+				if (region_set.contains(tile))
 				{
 					if (rng->getInt(0, 100) > 90) continue;
 
@@ -591,29 +582,28 @@ void WorldCrafting::create_shrine(Level& level, PeopleMapping& mapping, int regi
 void WorldCrafting::create_abandoned_warehouse(Level& level, PeopleMapping& mapping, int region, std::vector<WorldPosition> tiles, WorldPosition center)
 {
 
-	TCODRandom* rng = TCODRandom::getInstance();
+	TCODRandom* rng = region_rng;
 
 	static constexpr int sym_size = 2;
 	static char syms[sym_size]{ WIRE_SYM, CHEST_SYM };
 
 	for (auto tile : tiles)
 	{
+		auto& cell = level.tile(tile.x, tile.y);
 		if (rng->getInt(0, 100) > 90)
-			level.dig[tile.x][tile.y] = rng->getInt('v', 'y');
+			cell.dig = rng->getInt('v', 'y');
 		else
-			level.dig[tile.x][tile.y] = rng->getInt(0, 100) >= 50 ? FLOOR_SYM : '.';
+			cell.dig = rng->getInt(0, 100) >= 50 ? FLOOR_SYM : '.';
 
-		level.hues[tile.x][tile.y] = rng->getFloat(-5.0f, 75.0f);
-		level.sats[tile.x][tile.y] = rng->getFloat(0.4f, 0.7f);
+		cell.hue = rng->getFloat(-5.0f, 75.0f);
+		cell.sat = rng->getFloat(0.4f, 0.7f);
 	}
 
-	shuffle(tiles);
+	// spread out rather than clumped, a quarter of the floor at most
+	sampler.sample(tiles, 2, rng, picks, tiles.size() / 4);
 
-	for (int i = 0; i < tiles.size() / 4; i++)
+	for (auto tile : picks)
 	{
-		auto tile = tiles.back();
-		tiles.pop_back();
-
 		auto ware = create_wares(tile, 'Z' + rng->getInt(1, 12));
 		add_component<Colored>(ware, HSL(rng->getFloat(0.0f, 360.0f), rng->getFloat(0.15f, 0.35f), 1.0f));
 		remove_component<Blocked>(ware);
@@ -626,7 +616,7 @@ void WorldCrafting::create_black_market(Level& level, PeopleMapping& mapping, in
 
 void WorldCrafting::create_monolith(Level& level, PeopleMapping& mapping, int region, std::vector<WorldPosition> tiles, WorldPosition center)
 {
-	TCODRandom* rng = TCODRandom::getInstance();
+	TCODRandom* rng = region_rng;
 
 	int i = rng->getInt(0, tiles.size() - 1);
 	center = tiles[i];
@@ -635,9 +625,10 @@ void WorldCrafting::create_monolith(Level& level, PeopleMapping& mapping, int re
 	int c = 0;
 	for (auto tile : tiles)
 	{
-		level.hues[tile.x][tile.y] = rng->getFloat(-20.0f, 20.0f);
-		level.sats[tile.x][tile.y] = tile.distance(center) / 10.0f;
-		level.vals[tile.x][tile.y] = rng->getFloat(0.95f, 1.0f);
+		auto& cell = level.tile(tile.x, tile.y);
+		cell.hue = rng->getFloat(-20.0f, 20.0f);
+		cell.sat = tile.distance(center) / 10.0f;
+		cell.val = rng->getFloat(0.95f, 1.0f);
 
 		if (i == c)
 		{
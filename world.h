@@ -1,6 +1,7 @@
 #pragma once
 
 #include "engine.h"
+#include "sampling.h"
 
 #include <any>
 #include <unordered_map>
@@ -17,6 +18,14 @@ struct WorldCrafting
     , public AccessYAML    
 {
     void execute_crafting() override;
+
+    // every region is furnished from its own stream, so regions don't shift each other's contents
+    TCODRandom* region_rng = nullptr;
+
+    // the region being furnished, for lookups from bounding-box sweeps
+    TileSet region_set;
+    PoissonDiskSampler sampler;
+    std::vector<WorldPosition> picks;
         
     void create_warehouse(Level& level, PeopleMapping& mapping, int region, std::vector<WorldPosition> tiles, WorldPosition center);
     void create_machine_shop(Level& level, PeopleMapping& mapping, int region, std::vector<WorldPosition> tiles, WorldPosition center);